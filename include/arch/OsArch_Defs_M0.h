@@ -26,6 +26,16 @@
 #define OS_PORT_SVC_NVIC_PRIO 		0xFF
 #define OS_PORT_TICKER_NVIC_PRIO 	0xFE
 
+#define OS_PORT_SYSTICK_ENABLE		0x01
+#define OS_PORT_SYSTICK_COUNTFLAG	0x10000
+#define OS_PORT_SYSTICK_MAX_LOAD	0xFFFFFF
+#define OS_PORT_ICSR_PENDSTSET		(1UL << 26)
+
+/*
+ * Sleeps the core until next interrupt (wakes even with primask set):
+ */
+#define OS_PORT_WAIT_FOR_IRQ()		__asm volatile ("dsb \n wfi \n isb" ::: "memory")
+
 
 
 
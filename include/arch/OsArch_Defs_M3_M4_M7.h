@@ -27,6 +27,32 @@
 #define OS_PORT_SVC_NVIC_PRIO 		0xFF
 #define OS_PORT_TICKER_NVIC_PRIO 	0xFE
 
+#define OS_PORT_SYSTICK_ENABLE		0x01
+#define OS_PORT_SYSTICK_COUNTFLAG	0x10000
+#define OS_PORT_SYSTICK_MAX_LOAD	0xFFFFFF
+#define OS_PORT_ICSR_PENDSTSET		(1UL << 26)
+
+#define OS_PORT_EXC_RETURN_THREAD	0xFFFFFFFD	//thread mode, psp, no fp frame
+#define OS_PORT_CPACR_FPU_FULL		(0x0F << 20)	//cp10 and cp11 full access
+#define OS_PORT_FPCCR_ASPEN			(1UL << 31)	//fp context stacked on exception
+#define OS_PORT_FPCCR_LSPEN			(1UL << 30)	//fp stacking deferred (lazy)
+#define OS_PORT_DEMCR_TRCENA		(1UL << 24)	//enables dwt and itm units
+#define OS_PORT_DWT_CYCCNTENA		(1UL << 0)	//enables the cycle counter
+#define OS_PORT_DWT_LAR_KEY			0xC5ACCE55	//unlocks dwt on cortex m7
+
+/*
+ * Sleeps the core until next interrupt (wakes even with primask set), an
+ * irq masked by basepri does not wake the core, so primask takes its place
+ * while sleeping:
+ */
+#if OS_MAX_SYSCALL_IRQ_PRIO > 0
+#define OS_PORT_WAIT_FOR_IRQ()		__asm volatile ("cpsid i \n mrs r0, basepri \n movs r1, #0 \n"	\
+													"msr basepri, r1 \n dsb \n wfi \n isb \n"		\
+													"msr basepri, r0 \n cpsie i" ::: "r0", "r1", "memory")
+#else
+#define OS_PORT_WAIT_FOR_IRQ()		__asm volatile ("dsb \n wfi \n isb" ::: "memory")
+#endif
+
 
 /** \brief  Structure type to access the System Timer (SysTick).
  */
@@ -66,11 +92,38 @@ typedef struct
   volatile  uint32_t CPACR;                   /*!< Offset: 0x088 (R/W)  Coprocessor Access Control Register                   */
 } SCB_Type;
 
+/** \brief  Structure type to access the Floating Point Unit (FPU).
+ */
+typedef struct
+{
+  volatile  uint32_t RESERVED0[1];
+  volatile uint32_t FPCCR;                   /*!< Offset: 0x004 (R/W)  Floating-Point Context Control Register               */
+  volatile uint32_t FPCAR;                   /*!< Offset: 0x008 (R/W)  Floating-Point Context Address Register               */
+  volatile uint32_t FPDSCR;                  /*!< Offset: 0x00C (R/W)  Floating-Point Default Status Control Register        */
+  volatile  uint32_t MVFR0;                   /*!< Offset: 0x010 (R/ )  Media and FP Feature Register 0                       */
+  volatile  uint32_t MVFR1;                   /*!< Offset: 0x014 (R/ )  Media and FP Feature Register 1                       */
+} FPU_Type;
+
+/** \brief  Structure type to access the Data Watchpoint and Trace Register (DWT).
+ */
+typedef struct
+{
+  volatile uint32_t CTRL;                    /*!< Offset: 0x000 (R/W)  Control Register                                      */
+  volatile uint32_t CYCCNT;                  /*!< Offset: 0x004 (R/W)  Cycle Count Register                                  */
+  volatile  uint32_t RESERVED0[1003];
+  volatile uint32_t LAR;                     /*!< Offset: 0xFB0 ( /W)  Lock Access Register                                  */
+} DWT_Type;
+
 #define SysTick_BASE        (0xE000E000UL +  0x0010UL)
 #define SCB_BASE            (0xE000E000UL +  0x0D00UL)
+#define FPU_BASE            (0xE000E000UL +  0x0F30UL)
+#define DWT_BASE            (0xE0001000UL)
+#define DEMCR               (*(volatile uint32_t *)0xE000EDFCUL)   /*!< Debug Exception and Monitor Control Register */
 
 #define SCB                 ((SCB_Type       *)     SCB_BASE      )   /*!< SCB configuration struct           */
 #define SysTick             ((SysTick_Type   *)     SysTick_BASE  )   /*!< SysTick configuration struct       */
+#define FPU                 ((FPU_Type       *)     FPU_BASE      )   /*!< FPU configuration struct           */
+#define DWT                 ((DWT_Type       *)     DWT_BASE      )   /*!< DWT configuration struct           */
 
 /*
  *  todo add ICACHE and DACHE macros.
@@ -93,6 +146,12 @@ struct ctx_
 	uint32_t r10;
 	uint32_t r11;
 
+#if OS_ARCH_FPU_EN > 0
+	//exception return of the task, when bit 4 is clear s16-s31 are
+	//stacked between this field and an extended hardware frame:
+	uint32_t excReturn;
+#endif
+
 	//These are the hardware context saved registers.
 	uint32_t r0;
 	uint32_t r1;
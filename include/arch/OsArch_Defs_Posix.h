@@ -0,0 +1,57 @@
+/*!
+ *
+ * 							ULIPE RTOS VERSION 4
+ *
+ *
+ *  \file OsArch_Defs_Posix.h
+ *
+ *  \brief this file is contains the host dependent macros and definitions
+ *
+ *	The posix port runs the kernel as a single linux process, tasks are
+ *	ucontext coroutines and the tick is delivered by a timer signal, the
+ *	signal handler plays the role of the interrupt handlers.
+ *
+ *  Author: FSN
+ *
+ */
+#include "uLipeRtos4.h"
+
+#ifndef __OS_ARCH_DEFS_POSIX_H
+#define __OS_ARCH_DEFS_POSIX_H
+
+#if (OS_ARCH_POSIX == 1)
+
+#include <ucontext.h>
+#include <signal.h>
+
+/*
+ *  Host dependent macros:
+ */
+
+#define OS_PORT_TICK_SIGNAL			SIGALRM
+#define OS_PORT_CORE_SIGNAL			SIGUSR1		//inter core irq on multicore
+#define OS_PORT_NSEC_PER_SEC		1000000000ULL
+
+/*
+ * host stack of each task, the C library needs much more stack than the
+ * kernel one, so tasks run on a stack taken from host memory:
+ */
+#ifndef OS_PORT_HOST_STACK_SIZE
+#define OS_PORT_HOST_STACK_SIZE		(64 * 1024)
+#endif
+
+/*
+ * Task context data structure:
+ */
+struct ctx_
+{
+	ucontext_t uc;				//host saved context
+	void (*entry)(void *);		//task entry point
+	void *args;					//task entry arguments
+};
+
+typedef struct ctx_   PosixCtx_t;
+typedef struct ctx_ * PosixCtxPtr_t;
+
+#endif
+#endif
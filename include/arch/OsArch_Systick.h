@@ -0,0 +1,109 @@
+/*!
+ *
+ * 							ULIPE RTOS VERSION 4
+ *
+ *
+ *  \file OsArch_Systick.h
+ *
+ *  \brief this file contains the systick tickless sleep shared by the
+ *  cortex-m ports
+ *
+ *
+ *  Author: FSN
+ *
+ */
+#include "uLipeRtos4.h"
+#include "include/arch/OsArch_Defs_M0.h"
+#include "include/arch/OsArch_Defs_M3_M4_M7.h"
+
+#ifndef __OS_ARCH_SYSTICK_H
+#define __OS_ARCH_SYSTICK_H
+
+#if (OS_ARCH_CORTEX_M0 == 1) || (OS_ARCH_CORTEX_M7 == 1) || (OS_ARCH_CORTEX_M4 == 1) || (OS_ARCH_CORTEX_M3 == 1)
+#if OS_TICKLESS_IDLE_EN > 0
+
+/*!
+ *  \brief whole ticks elapsed in a sleep started v0 cycles before a tick boundary
+ *
+ *  \param v0 - cycles left in the current tick when the sleep started
+ *  \param elapsed - cycles slept
+ *  \param load - cycles per tick
+ *  \param next - receives the cycles up to the next tick boundary
+ *
+ *  \return number of tick boundaries crossed
+ */
+static inline uint32_t uLipePortSystickElapsed(uint32_t v0, uint32_t elapsed, uint32_t load, uint32_t *next)
+{
+	uint32_t ticks = 0;
+
+	//the first boundary is v0 away, the following ones are load apart:
+	if(elapsed >= v0) ticks = 1 + ((elapsed - v0) / load);
+	*next = v0 + (ticks * load) - elapsed;
+
+	return(ticks);
+}
+
+/*!
+ *  \brief stops the periodic tick and sleeps up to ticks tick periods
+ *
+ *  \param ticks - tick periods to sleep
+ *  \param load - cycles per tick
+ *
+ *  \return ticks elapsed not yet accounted by the systick interrupt
+ */
+static inline uint32_t uLipePortSystickSleep(uint32_t ticks, uint32_t load)
+{
+	uint32_t v0;
+	uint32_t reload;
+	uint32_t elapsed;
+	uint32_t next;
+	uint32_t ctrl;
+
+	//systick is only 24bit wide, limit the sleep period:
+	if(ticks > (OS_PORT_SYSTICK_MAX_LOAD / load)) ticks = OS_PORT_SYSTICK_MAX_LOAD / load;
+
+	//Stop the timer, keep the phase of the current tick:
+	SysTick->CTRL &= ~OS_PORT_SYSTICK_ENABLE;
+	v0 = SysTick->VAL;
+	if(v0 == 0) v0 = load;
+
+	reload = v0 + (load * (ticks - 1));
+	SysTick->LOAD = reload;
+	SysTick->VAL = 0;
+	SysTick->CTRL |= OS_PORT_SYSTICK_ENABLE;
+
+	//sleep until the deadline or any other interrupt:
+	OS_PORT_WAIT_FOR_IRQ();
+
+	//Stop the timer again, reading ctrl also clears the count flag:
+	ctrl = SysTick->CTRL;
+	SysTick->CTRL = ctrl & ~OS_PORT_SYSTICK_ENABLE;
+
+	if(ctrl & OS_PORT_SYSTICK_COUNTFLAG)
+	{
+		//deadline reached, the pending systick irq accounts the last tick,
+		//so the next tick is loaded with what remains of the current one:
+		elapsed = reload - SysTick->VAL;
+		SysTick->LOAD = (elapsed < load) ? (load - elapsed) : load;
+		ticks = ticks - 1;
+	}
+	else
+	{
+		//woken by other interrupt, account the boundaries crossed
+		//and reload up to the next one, so the tick phase is kept:
+		elapsed = reload - SysTick->VAL;
+		ticks = uLipePortSystickElapsed(v0, elapsed, load, &next);
+		SysTick->LOAD = next;
+	}
+
+	//restart the periodic tick:
+	SysTick->VAL = 0;
+	SysTick->CTRL |= OS_PORT_SYSTICK_ENABLE;
+	SysTick->LOAD = load;
+
+	return(ticks);
+}
+
+#endif
+#endif
+#endif
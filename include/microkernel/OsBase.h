@@ -60,6 +60,10 @@ typedef enum						//Rtos status codes
 	kDeviceEnabled,					//
 	kDeviceDisabled,				//
 	kDeviceIoError,					//
+	kDeferQueueFull,				//
+	kMutexNotOwner,					//
+	kOutOfTimer,					//
+	kSetFull,						//
 }OsStatus_t;						//
 
 /*
@@ -89,6 +93,17 @@ typedef struct ecb_* EventPtr_t;
 #define OS_HIGHEST_PRIO  (OS_NUMBER_OF_TASKS - 1)
 #define OS_INVALID_PRIO (0xFFFF)
 
+/*
+ *  task slots, each priority has OS_TASKS_PER_PRIO task ids:
+ */
+#ifndef OS_TASKS_PER_PRIO
+#define OS_TASKS_PER_PRIO       1
+#endif
+
+#define OS_TASK_SLOTS           (OS_NUMBER_OF_TASKS * OS_TASKS_PER_PRIO)
+#define OS_TASK_ID(prio, n)     (((prio) * OS_TASKS_PER_PRIO) + (n))
+#define OS_TASK_PRIO(id)        ((id) / OS_TASKS_PER_PRIO)
+
 
 #if IDLE_TASK_HOOK_EN > 0
 /*
@@ -97,6 +112,13 @@ typedef struct ecb_* EventPtr_t;
 extern void IdleTaskHook(void);
 #endif
 
+#if OS_BUDGET_HOOK_EN > 0
+/*
+ * User Hook proto, called from the tick isr when a task exhausts its budget:
+ */
+extern void BudgetOverrunHook(uint16_t taskId);
+#endif
+
 
 /*
  *  assert definition:
@@ -129,6 +151,28 @@ static inline void _uLipeAssert(uint32_t x)
 #define OS_ARCH_MULTICORE       0
 #endif
 
+#ifndef OS_NUMBER_OF_CORES
+#define OS_NUMBER_OF_CORES      2
+#endif
+
+/* single core kernel keeps the per core data on a single entry */
+#if OS_ARCH_MULTICORE == 0
+#undef  OS_NUMBER_OF_CORES
+#define OS_NUMBER_OF_CORES      1
+#endif
+
+#ifndef OS_ARCH_FPU_EN
+#define OS_ARCH_FPU_EN          0
+#endif
+
+#ifndef OS_ARCH_POSIX
+#define OS_ARCH_POSIX           0
+#endif
+
+#ifndef OS_MAX_SYSCALL_IRQ_PRIO
+#define OS_MAX_SYSCALL_IRQ_PRIO 0
+#endif
+
 #ifndef OS_IDLE_TASK_HOOK_EN
 #define OS_IDLE_TASK_HOOK_EN    0
 #endif
@@ -141,6 +185,112 @@ static inline void _uLipeAssert(uint32_t x)
 #define OS_MINIMAL_STACK        32
 #endif
 
+#ifndef OS_STACK_MONITOR_EN
+#define OS_STACK_MONITOR_EN     0
+#endif
+
+#ifndef OS_STACK_OVERFLOW_CHECK_EN
+#define OS_STACK_OVERFLOW_CHECK_EN  0
+#endif
+
+#ifndef OS_TASK_STATS_EN
+#define OS_TASK_STATS_EN        0
+#endif
+
+#ifndef OS_TRACE_EN
+#define OS_TRACE_EN             0
+#endif
+
+#ifndef OS_CYCLE_COUNTER_EN
+#define OS_CYCLE_COUNTER_EN     0
+#endif
+
+/* statistics and trace are timestamped with the cycle counter */
+#if (OS_TASK_STATS_EN > 0) || (OS_TRACE_EN > 0)
+#undef  OS_CYCLE_COUNTER_EN
+#define OS_CYCLE_COUNTER_EN     1
+#endif
+
+#ifndef OS_TRACE_BUFFER_SIZE
+#define OS_TRACE_BUFFER_SIZE    256
+#endif
+
+#ifndef OS_TICKLESS_IDLE_EN
+#define OS_TICKLESS_IDLE_EN     0
+#endif
+
+#ifndef OS_TASK_NOTIFY_EN
+#define OS_TASK_NOTIFY_EN       0
+#endif
+
+#ifndef OS_ROUND_ROBIN_EN
+#define OS_ROUND_ROBIN_EN       0
+#endif
+
+#ifndef OS_TIME_SLICE_TICKS
+#define OS_TIME_SLICE_TICKS     10
+#endif
+
+#ifndef OS_EDF_EN
+#define OS_EDF_EN               0
+#endif
+
+#ifndef OS_EDF_PRIO
+#define OS_EDF_PRIO             1
+#endif
+
+#ifndef OS_TASK_BUDGET_EN
+#define OS_TASK_BUDGET_EN       0
+#endif
+
+#ifndef OS_BUDGET_DEMOTE_PRIO
+#define OS_BUDGET_DEMOTE_PRIO   1
+#endif
+
+#ifndef OS_BUDGET_HOOK_EN
+#define OS_BUDGET_HOOK_EN       0
+#endif
+
+#ifndef OS_DEFERRED_POST_EN
+#define OS_DEFERRED_POST_EN     0
+#endif
+
+#ifndef OS_DEFER_QUEUE_SIZE
+#define OS_DEFER_QUEUE_SIZE     16
+#endif
+
+#ifndef OS_TIMER_WHEEL_SIZE
+#define OS_TIMER_WHEEL_SIZE     16
+#endif
+
+#ifndef OS_RING_MODULE_EN
+#define OS_RING_MODULE_EN       0
+#endif
+
+#ifndef OS_STREAM_MODULE_EN
+#define OS_STREAM_MODULE_EN     0
+#endif
+
+#ifndef OS_SET_MODULE_EN
+#define OS_SET_MODULE_EN        0
+#endif
+
+#ifndef OS_TIMER_MODULE_EN
+#define OS_TIMER_MODULE_EN      0
+#endif
+
+#ifndef OS_TIMER_DAEMON_PRIO
+#define OS_TIMER_DAEMON_PRIO    (OS_NUMBER_OF_TASKS - 1)
+#endif
+
+#ifndef OS_TIMER_DAEMON_STACK_SIZE
+#define OS_TIMER_DAEMON_STACK_SIZE  128
+#endif
+
+#ifndef OS_TICKLESS_MIN_IDLE_TICKS
+#define OS_TICKLESS_MIN_IDLE_TICKS  2
+#endif
+
 
 #ifndef OS_DELAY_TIME_BASE
 #define OS_DELAY_TIME_BASE      (10000/(OS_TICKS_PER_SECOND)) //In steps of 0.1ms
@@ -154,11 +304,86 @@ static inline void _uLipeAssert(uint32_t x)
 #define OS_NUMBER_OF_TASKS      1
 #endif
 
+#if (OS_TIMER_WHEEL_SIZE & (OS_TIMER_WHEEL_SIZE - 1)) != 0
+  #error "uLipeKernel: timer wheel size must be a power of 2"
+#endif
+
+#if (OS_TIMER_MODULE_EN > 0) && ((OS_TIMER_DAEMON_PRIO == 0) || (OS_TIMER_DAEMON_PRIO > (OS_NUMBER_OF_TASKS - 1)))
+  #error "uLipeKernel: timer daemon prio must be above idle and below the number of tasks"
+#endif
+
+#if (OS_EDF_EN > 0) && ((OS_EDF_PRIO == 0) || (OS_EDF_PRIO > (OS_NUMBER_OF_TASKS - 1)))
+  #error "uLipeKernel: edf band prio must be above idle and below the number of tasks"
+#endif
+
+#if (OS_TASK_BUDGET_EN > 0) && ((OS_BUDGET_DEMOTE_PRIO == 0) || (OS_BUDGET_DEMOTE_PRIO > (OS_NUMBER_OF_TASKS - 1)))
+  #error "uLipeKernel: budget demote prio must be above idle and below the number of tasks"
+#endif
+
+#if (OS_TRACE_BUFFER_SIZE & (OS_TRACE_BUFFER_SIZE - 1)) != 0
+  #error "uLipeKernel: trace buffer size must be a power of 2"
+#endif
+
+#if (OS_DEFER_QUEUE_SIZE & (OS_DEFER_QUEUE_SIZE - 1)) != 0
+  #error "uLipeKernel: deferred post queue size must be a power of 2"
+#endif
+
+#if ((OS_TASKS_PER_PRIO & (OS_TASKS_PER_PRIO - 1)) != 0) || (OS_TASKS_PER_PRIO > 32)
+  #error "uLipeKernel: tasks per prio must be a power of 2 up to 32"
+#endif
+
+#if (OS_TASK_SLOTS > 1024)
+  #error "uLipeKernel: up to 1024 tasks slots are supported"
+#endif
+
 /* no support to fast sched in cortex cm0 */
 #if (OS_ARCH_CORTEX_M0 == 1) && (OS_FAST_SCHED == 1)
   #error "uLipeKernel: this architecture does not provide hw optimized scheduler"
 #endif
 
+/* host port uses the portable scheduler */
+#if (OS_ARCH_POSIX == 1) && (OS_FAST_SCHED == 1)
+  #error "uLipeKernel: this architecture does not provide hw optimized scheduler"
+#endif
+
+/* host port cannot be built together with a cortex port */
+#if (OS_ARCH_POSIX == 1) && ((OS_ARCH_CORTEX_M0 == 1) || (OS_ARCH_CORTEX_M3 == 1) || \
+		(OS_ARCH_CORTEX_M4 == 1) || (OS_ARCH_CORTEX_M7 == 1))
+  #error "uLipeKernel: select only one architecture"
+#endif
+
+/* multicore needs a port with core id, spinlock and inter core irqs */
+#if (OS_ARCH_MULTICORE > 0) && (OS_ARCH_POSIX != 1)
+  #error "uLipeKernel: this architecture does not support multicore"
+#endif
+
+#if (OS_ARCH_MULTICORE > 0) && ((OS_NUMBER_OF_CORES < 2) || (OS_NUMBER_OF_CORES > 32))
+  #error "uLipeKernel: multicore supports from 2 up to 32 cores"
+#endif
+
+/* the idle task of each core takes a slot of least priority */
+#if (OS_ARCH_MULTICORE > 0) && (OS_TASKS_PER_PRIO < OS_NUMBER_OF_CORES)
+  #error "uLipeKernel: multicore needs at least one task per prio for each core"
+#endif
+
+#if (OS_ARCH_MULTICORE > 0) && (OS_TICKLESS_IDLE_EN > 0)
+  #error "uLipeKernel: tickless idle is not supported on multicore"
+#endif
+
+/* basepri exists only on armv7-m, systick must stay maskable by it */
+#if (OS_MAX_SYSCALL_IRQ_PRIO > 0) && (OS_ARCH_CORTEX_M3 != 1) && (OS_ARCH_CORTEX_M4 != 1) && (OS_ARCH_CORTEX_M7 != 1)
+  #error "uLipeKernel: OS_MAX_SYSCALL_IRQ_PRIO needs cortex m3, m4 or m7"
+#endif
+
+#if (OS_MAX_SYSCALL_IRQ_PRIO > 0xFE)
+  #error "uLipeKernel: OS_MAX_SYSCALL_IRQ_PRIO must not be lower than systick priority (0xFE)"
+#endif
+
+/* only cortex m4f and m7 have a floating point unit */
+#if (OS_ARCH_FPU_EN > 0) && (OS_ARCH_CORTEX_M4 != 1) && (OS_ARCH_CORTEX_M7 != 1)
+  #error "uLipeKernel: this architecture does not provide a floating point unit"
+#endif
+
 /*
  *  Assert macro is particular useful for debbuging purposes, so in
  *  Debug configurations it will always defined, in release this macro
@@ -37,6 +37,32 @@
 #define OS_ARCH_CORTEX_M4     0
 #define OS_ARCH_CORTEX_M7     0
 
+//
+// Save the floating point context of tasks that use the FPU,
+// available on Cortex-M4F and M7 only:
+//
+#define OS_ARCH_FPU_EN		  0
+
+//
+// Critical sections through BASEPRI, Cortex-M3/M4/M7 only, 0 masks all
+// the interrupts with PRIMASK, otherwise the NVIC priority register value
+// (aligned to the implemented bits) of the highest priority irq allowed
+// to call the kernel, irqs above it are never delayed by the kernel:
+//
+#define OS_MAX_SYSCALL_IRQ_PRIO	  0
+
+//
+// Host (linux) port, the kernel runs as a process for simulation
+// and testing, disable the ARM Cortex selection when using it:
+//
+#define OS_ARCH_POSIX		  0
+
+//
+// Symmetric multicore, all the cores run tasks of the same kernel, the
+// port provides the core id, the kernel spinlock and inter core irqs:
+//
+#define OS_ARCH_MULTICORE	  0
+#define OS_NUMBER_OF_CORES	  2
 
 //
 // Other archs TBD
@@ -49,12 +75,83 @@
 #define OS_FAST_SCHED           	0
 #define OS_MINIMAL_STACK            32
 
+/*
+ * 	stack monitor, stacks are painted at task creation to measure its
+ * 	high water mark, and the overflow check traps on context switch
+ * 	when the canary placed on the stack limit was overwritten:
+ */
+#define OS_STACK_MONITOR_EN			0
+#define OS_STACK_OVERFLOW_CHECK_EN	0
+
+/*
+ * 	per task runtime statistics, cycles consumed, switches and preemptions,
+ * 	measured on every context switch:
+ */
+#define OS_TASK_STATS_EN			0
+
+/*
+ * 	cpu cycle counter available to application (benchmarks), it is
+ * 	always enabled when statistics or trace are used:
+ */
+#define OS_CYCLE_COUNTER_EN			0
+
+/*
+ * 	trace recorder, kernel events are stored on a ram ring buffer
+ * 	with cycle timestamps, buffer size in records MUST be power of 2:
+ */
+#define OS_TRACE_EN					0
+#define OS_TRACE_BUFFER_SIZE		256
+
+/*
+ * 	tickless idle, stops the periodic tick when only idle task is ready
+ * 	and wake up the machine on the earliest delay expiration:
+ */
+#define OS_TICKLESS_IDLE_EN			0
+#define OS_TICKLESS_MIN_IDLE_TICKS	2 //idle periods shorter than this keep the tick
+
+/*
+ * 	deferred posts, the FromISR apis only record the post which is executed
+ * 	when the outermost isr exits, queue size MUST be power of 2:
+ */
+#define OS_DEFERRED_POST_EN			0
+#define OS_DEFER_QUEUE_SIZE			16
+
+/*
+ * 	timer wheel buckets, delayed tasks are hashed by its expiration tick,
+ * 	MUST be power of 2:
+ */
+#define OS_TIMER_WHEEL_SIZE			16
+
 /*
  * 	task kernel objects and generation code:
  */
 
 #define OS_NUMBER_OF_TASKS 			  	8 //MUST BE > 0
+#define OS_TASKS_PER_PRIO				1 //Tasks sharing a prio, MUST BE power of 2
 #define OS_TASK_MODULE_EN			    1 //Gererate code for task management
+#define OS_TASK_NOTIFY_EN				0 //Direct to task notifications
+
+/*
+ *  round robin between tasks of same prio, the quantum can be changed
+ *  on each prio using uLipeTaskTimeSlice():
+ */
+#define OS_ROUND_ROBIN_EN				0
+#define OS_TIME_SLICE_TICKS				10 //default quantum in ticks
+
+/*
+ *  earliest deadline first band, the tasks created with uLipeTaskCreateEdf()
+ *  share this prio and run by its absolute deadlines, up to OS_TASKS_PER_PRIO:
+ */
+#define OS_EDF_EN						0
+#define OS_EDF_PRIO						4 //MUST BE above idle and < OS_NUMBER_OF_TASKS
+
+/*
+ *  cpu budgets, a task given a budget with uLipeTaskBudget() runs up to it
+ *  on each replenishment period, then it is throttled or demoted to this prio:
+ */
+#define OS_TASK_BUDGET_EN				0
+#define OS_BUDGET_DEMOTE_PRIO			1 //MUST BE above idle and < OS_NUMBER_OF_TASKS
+#define OS_BUDGET_HOOK_EN				0 //calls BudgetOverrunHook() on each overrun
 
 
 /*
@@ -87,6 +184,28 @@
  */
 #define OS_QUEUE_MODULE_EN		      1
 
+/*
+ * Single producer single consumer ring buffers, isr to task streaming:
+ */
+#define OS_RING_MODULE_EN			  0
+
+/*
+ * Stream buffers, variable length byte data with blocking send and receive:
+ */
+#define OS_STREAM_MODULE_EN			  0
+
+/*
+ * Object sets, a task waits on several sems, queues and flags at once:
+ */
+#define OS_SET_MODULE_EN			  0
+
+/*
+ * Software timers, callbacks are called by a daemon task:
+ */
+#define OS_TIMER_MODULE_EN			  0
+#define OS_TIMER_DAEMON_PRIO		  7 //MUST BE above idle and < OS_NUMBER_OF_TASKS
+#define OS_TIMER_DAEMON_STACK_SIZE	  128
+
 
 
 /*
@@ -63,7 +63,7 @@ Device_t* uLipeDeviceOpen(const char *devName, OsStatus_t *err);
  *  \brief Start device syncrhonization with I/O operation
  *
  */
-OsStatus_t uLipeDeviceStartSync(Device_t *dev, uint16_t timeout);
+OsStatus_t uLipeDeviceStartSync(Device_t *dev, uint32_t timeout);
 
 
 /*!
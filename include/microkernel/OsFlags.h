@@ -23,7 +23,7 @@
  */
 
 #define OS_FLAGS_PEND_ALL	0x01	//Wait for a specific group
-#define OS_FLAGS_PEND_ANY   0x02	//Wait for any flag in group
+#define OS_FLAGS_PEND_ANY   0x02	//Wait for any flag of the pended ones
 #define OS_FLAGS_CONSUME    0x04	//COnsume these flag after its asserted
 
 /*
@@ -33,8 +33,10 @@
 struct flag_
 {
 	uint32_t        flagRegister;					 //flagGrpRegister
-	OsPrioList_t    waitTasks[2];
-    uint8_t         activeList;
+	OsPrioList_t    bitWait[32];					 //waiters indexed by each flag they pend
+#if OS_SET_MODULE_EN > 0
+	struct objset_  *set;						 //set this object is linked to
+#endif
 };
 
 typedef struct flag_  FlagsGrp_t;
@@ -60,7 +62,24 @@ OsHandler_t uLipeFlagsCreate(OsStatus_t *err);
  *  \param
  *  \return
  */
-OsStatus_t uLipeFlagsPend(OsHandler_t h, uint32_t flags, uint8_t opt, uint16_t timeout);
+OsStatus_t uLipeFlagsPend(OsHandler_t h, uint32_t flags, uint8_t opt, uint32_t timeout);
+
+/*!
+ *  uLipeFlagsPendUntil()
+ *  \brief Make a task to pend for flags up to an absolute tick
+ *  \param deadline - tick of uLipeKernelTickGet() where the wait fails
+ *  \return
+ */
+OsStatus_t uLipeFlagsPendUntil(OsHandler_t h, uint32_t flags, uint8_t opt, uint32_t deadline);
+
+/*!
+ *  uLipeFlagsPendMatch()
+ *  \brief Make a task to pend for flags and gives the flags which released
+ *  it, so the register does not need to be read again
+ *  \param match - receives the pended flags found asserted, before consume
+ *  \return kTimeout if the flags were not asserted in time
+ */
+OsStatus_t uLipeFlagsPendMatch(OsHandler_t h, uint32_t flags, uint8_t opt, uint32_t timeout, uint32_t *match);
 
 /*!
  *  uLipeFlagsPost()
@@ -77,6 +96,17 @@ OsStatus_t uLipeFlagsPost(OsHandler_t h, uint32_t flags);
  */
 OsStatus_t uLipeFlagsDelete(OsHandler_t *h );
 
+#if OS_DEFERRED_POST_EN > 0
+/*!
+ *  uLipeFlagsPostFromISR()
+ *  \brief Assert flag bits from a isr, the post is deferred until the
+ *  outermost isr exits
+ *  \param
+ *  \return kDeferQueueFull if the post could not be recorded
+ */
+OsStatus_t uLipeFlagsPostFromISR(OsHandler_t h, uint32_t flags);
+#endif
+
 
 
 #endif
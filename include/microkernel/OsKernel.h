@@ -27,6 +27,43 @@
 
 #define OS_KERNEL_ENTRIES_FOR_GROUP  31
 #define OS_IDLE_TASK_STACK_SIZE      32
+#define OS_TICKLESS_NO_TIMEOUT       0xFFFFFFFF
+#define OS_DEADLINE_WINDOW           0x7FFFFFFF	//ticks ahead a deadline can be
+#define OS_TIMER_WHEEL_MASK          (OS_TIMER_WHEEL_SIZE - 1)
+#define OS_DEFER_QUEUE_MASK          (OS_DEFER_QUEUE_SIZE - 1)
+
+/*
+ * task control block, defined on task module:
+ */
+struct OsTCB_;
+
+/*
+ * running and next task of executing core, on multicore the
+ * current task is read with the core interrupts masked, so the
+ * caller cannot migrate between reading core id and its entry:
+ */
+#if OS_ARCH_MULTICORE > 0
+#define OS_CORE_ID()                 uLipePortCoreId()
+#define OS_CORE_NONE                 0xFFFF
+#define OS_CORE_ALL                  (0xFFFFFFFF >> (32 - OS_NUMBER_OF_CORES))
+
+extern struct OsTCB_ *osCoreCurrentTask[OS_NUMBER_OF_CORES];
+extern struct OsTCB_ *osCoreHighPrioTask[OS_NUMBER_OF_CORES];
+
+#define currentTask                  uLipeKernelCurrentTask()
+#define highPrioTask                 osCoreHighPrioTask[OS_CORE_ID()]
+#define OS_CORE_CURRENT(core)        osCoreCurrentTask[(core)]
+#define OS_CORE_HIGH_PRIO(core)      osCoreHighPrioTask[(core)]
+#else
+#define OS_CORE_ID()                 0
+#define OS_CORE_ALL                  0x01
+
+extern struct OsTCB_ *currentTask;
+extern struct OsTCB_ *highPrioTask;
+
+#define OS_CORE_CURRENT(core)        currentTask
+#define OS_CORE_HIGH_PRIO(core)      highPrioTask
+#endif
 
 /*
  * 	Priority list object:
@@ -34,7 +71,7 @@
 struct OsPrioList_
 {
 	uint32_t prioGrp;
-	uint32_t prioTbl[(OS_NUMBER_OF_TASKS/32) + 1];
+	uint32_t prioTbl[(OS_TASK_SLOTS/32) + 1];
 };
 
 typedef struct OsPrioList_  OsPrioList_t;
@@ -53,6 +90,21 @@ struct dualpriolist_
 typedef struct dualpriolist_  OsDualPrioList_t;
 typedef struct dualpriolist_* OsDualPrioListPtr_t;
 
+/*
+ * Deferred post, a kernel call recorded by an isr:
+ */
+typedef void (*OsDeferredFunc_t)(OsHandler_t h, uintptr_t arg);
+
+struct deferred_
+{
+	OsDeferredFunc_t func;		//post routine of the kernel object
+	OsHandler_t h;				//kernel object
+	uintptr_t arg;				//post argument
+};
+
+typedef struct deferred_  OsDeferred_t;
+typedef struct deferred_* OsDeferredPtr_t;
+
 
 /*
  *  Kernel functions proto:
@@ -82,6 +134,138 @@ void uLipeKernelIrqIn(void);
  */
 void uLipeKernelIrqOut(void);
 
+/*!
+ * 	uLipeKernelTickGet()
+ *
+ *  \brief Reads the kernel tick counter, base of the absolute deadlines,
+ *  it wraps around after 2^32 ticks
+ *  \param
+ *
+ *  \return current tick
+ *
+ */
+uint32_t uLipeKernelTickGet(void);
+
+/*!
+ * 	uLipeSchedLock()
+ *
+ *  \brief Prevents the current task from being switched, kernel calls
+ *  still update the ready tasks but no context switch happens until
+ *  the matching unlock, calls can be nested
+ *  \param
+ *
+ *  \return
+ *  \note the current task must not block while the scheduler is locked
+ *
+ */
+void uLipeSchedLock(void);
+
+/*!
+ * 	uLipeSchedUnlock()
+ *
+ *  \brief Releases one level of scheduler lock, the last unlock selects
+ *  the highest priority task ready to run
+ *  \param
+ *
+ *  \return
+ *
+ */
+void uLipeSchedUnlock(void);
+
+#if OS_ARCH_MULTICORE > 0
+/*!
+ * 	uLipeKernelLockIn()
+ *
+ *  \brief Masks the interrupts of calling core and takes the kernel
+ *  spinlock, it can be nested by the same core
+ *  \param
+ *
+ *  \return interrupt status to be restored
+ *
+ */
+uint32_t uLipeKernelLockIn(void);
+
+/*!
+ * 	uLipeKernelLockOut()
+ *
+ *  \brief Releases the kernel spinlock on the outermost call and
+ *  restores the interrupts of calling core
+ *  \param sReg - status returned by the matching lock in
+ *
+ *  \return
+ *
+ */
+void uLipeKernelLockOut(uint32_t sReg);
+
+/*!
+ * 	uLipeKernelCurrentTask()
+ *
+ *  \brief Reads the task running on calling core
+ *  \param
+ *
+ *  \return current tcb
+ *
+ */
+struct OsTCB_ *uLipeKernelCurrentTask(void);
+
+/*!
+ * 	uLipeKernelCoreNextTask()
+ *
+ *  \brief Selects the highest priority task ready on calling core, used
+ *  by the port context switch routine
+ *  \param
+ *
+ *  \return tcb of task to run
+ *  \note must be called holding the kernel spinlock
+ *
+ */
+struct OsTCB_ *uLipeKernelCoreNextTask(void);
+#endif
+
+#if (OS_TASK_STATS_EN > 0) || (OS_TRACE_EN > 0)
+/*!
+ * 	uLipeKernelSwitchHook()
+ *
+ *  \brief Accounts the runtime statistics and traces the switch from
+ *  current task to high prio task, called by the port on each context switch
+ *  \param
+ *
+ *  \return
+ *
+ */
+void uLipeKernelSwitchHook(void);
+#endif
+
+#if OS_TASK_STATS_EN > 0
+/*!
+ * 	uLipeKernelCpuLoad()
+ *
+ *  \brief Measures the cpu load from the idle task cycles
+ *  \param
+ *
+ *  \return cpu load since the previous call, in hundredths of percent
+ *
+ */
+uint16_t uLipeKernelCpuLoad(void);
+#endif
+
+#if OS_DEFERRED_POST_EN > 0
+/*!
+ * 	uLipeKernelDeferPost()
+ *
+ *  \brief Records a kernel call to be executed when the outermost isr
+ *  exits, so isrs keep the interrupts disabled for a constant time
+ *  \param func - routine that performs the post
+ *  \param h - kernel object to be posted
+ *  \param arg - argument of the post
+ *
+ *  \return kDeferQueueFull if no record is available
+ *  \note outside of isrs the post is executed immediately
+ *
+ */
+OsStatus_t uLipeKernelDeferPost(OsDeferredFunc_t func, OsHandler_t h, uintptr_t arg);
+#endif
+
 /*!
  * 	ulipeKernelFindHighPrio()
  *
@@ -108,6 +292,113 @@ extern uint16_t uLipeKernelFindHighPrio(OsPrioListPtr_t prioList);
  */
 void uLipeKernelTaskYield(void);
 
+/*!
+ * 	uLipeKernelTaskReady()
+ *
+ *  \brief Appends a task on the ready fifo of its priority
+ *  \param tcb - task to be made ready
+ *
+ *  \return
+ *  \note must be called with interrupts disabled
+ *
+ */
+void uLipeKernelTaskReady(struct OsTCB_ *tcb);
+
+/*!
+ * 	uLipeKernelTaskUnready()
+ *
+ *  \brief Removes a task from the ready fifo of its priority
+ *  \param tcb - task to be removed
+ *
+ *  \return
+ *  \note must be called with interrupts disabled
+ *
+ */
+void uLipeKernelTaskUnready(struct OsTCB_ *tcb);
+
+/*!
+ * 	uLipeKernelTaskPrioSet()
+ *
+ *  \brief Changes the level of the ready fifo of a task, used by mutexes
+ *  to lend and restore priorities, the task id is kept
+ *  \param tcb - task to be moved
+ *  \param prio - new priority level
+ *
+ *  \return
+ *  \note must be called with interrupts disabled
+ *
+ */
+void uLipeKernelTaskPrioSet(struct OsTCB_ *tcb, uint16_t prio);
+
+/*!
+ * 	uLipeKernelTaskBasePrio()
+ *
+ *  \brief Level a task runs when nothing is lent to it, its own priority
+ *  or the demotion one while its budget is exhausted
+ *  \param tcb - task to be checked
+ *
+ *  \return
+ *
+ */
+uint16_t uLipeKernelTaskBasePrio(struct OsTCB_ *tcb);
+
+#if OS_TASK_BUDGET_EN > 0
+/*!
+ * 	uLipeKernelBudgetSet()
+ *
+ *  \brief Changes the budget of a task, the current period restarts now
+ *  and an exhausted task gets back its level or leaves the throttling
+ *  \param tcb - task to be changed
+ *  \param budget - ticks allowed on each period, 0 removes the budget
+ *  \param period - ticks between replenishments
+ *  \param opt - overrun option
+ *
+ *  \return
+ *  \note must be called with interrupts disabled
+ *
+ */
+void uLipeKernelBudgetSet(struct OsTCB_ *tcb, uint32_t budget, uint32_t period, uint8_t opt);
+#endif
+
+/*!
+ * 	uLipeKernelTimerStart()
+ *
+ *  \brief Inserts a task on timer wheel, it expires after a amount of ticks
+ *  \param tcb - task to be delayed
+ *  \param ticks - relative timeout, must be greater than 0
+ *
+ *  \return
+ *  \note must be called with interrupts disabled
+ *
+ */
+void uLipeKernelTimerStart(struct OsTCB_ *tcb, uint32_t ticks);
+
+/*!
+ * 	uLipeKernelTimerStartAt()
+ *
+ *  \brief Inserts a task on timer wheel, it expires on an absolute tick,
+ *  a deadline already reached expires the task at once
+ *  \param tcb - task to be delayed, already on the wait lists of its object
+ *  \param wakeTick - absolute tick of expiration
+ *
+ *  \return
+ *  \note must be called with interrupts disabled
+ *
+ */
+void uLipeKernelTimerStartAt(struct OsTCB_ *tcb, uint32_t wakeTick);
+
+/*!
+ * 	uLipeKernelTimerStop()
+ *
+ *  \brief Removes a task from timer wheel, if it is delayed
+ *  \param tcb - task to be removed
+ *
+ *  \return
+ *  \note must be called with interrupts disabled
+ *
+ */
+void uLipeKernelTimerStop(struct OsTCB_ *tcb);
+
 /*!
  * 	ulipeKernelRtosTick()
  *
@@ -140,6 +431,18 @@ bool uLipeKernelIsRunning(void);
  */
 void uLipeKernelExecption(void);
 
+#if OS_STACK_OVERFLOW_CHECK_EN > 0
+/*!
+ *
+ * uLipeKernelStackOverflow()
+ *
+ * \brief called by the port when the stack canary of the task being
+ * switched out was overwritten, it does not return
+ *
+ */
+void uLipeKernelStackOverflow(struct OsTCB_ *tcb);
+#endif
+
 /*!
  * 	ulipeRtosInit()
  *
@@ -18,20 +18,16 @@
 #ifndef __OS_MUTEX_H
 #define __OS_MUTEX_H
 
-/*
- * Mutex priority value (default)
- */
-#define OS_MUTEX_PRIO (OS_HIGHEST_PRIO)
-
-
 /*
  * Mutex control block:
  */
 
 struct mutex_
 {
-	uint16_t mutexOwner;		//prio value of mutex owner
-	uint16_t mutexTaken;		//flag to mutex taken
+	uint16_t mutexOwner;		//id of mutex owner
+	uint16_t mutexTaken;		//times the owner took it, 0 when free
+	uint16_t ceilPrio;			//priority ceiling, 0 for inheritance only
+	struct mutex_ *heldNext;	//next mutex owned by the same task
 	OsPrioList_t tasksPending;  //tasks that pending the mutex
 };
 
@@ -46,16 +42,27 @@ typedef struct mutex_* MutexPtr_t;
 
 /*!
  * uLipeMutexCreate
- * \brief Creates a Mutex to be managed
+ * \brief Creates a Mutex to be managed, its owner inherits the priority
+ * of the highest task waiting for it
  * \param
  * \return
  */
 OsHandler_t uLipeMutexCreate(OsStatus_t *err);
 
+/*!
+ * uLipeMutexCreateCeiling
+ * \brief Creates a Mutex using priority ceiling, its owner runs at least
+ * on ceilPrio while holds it, the inheritance is kept on top of it
+ * \param ceilPrio - highest priority of the tasks sharing the mutex
+ * \return
+ */
+OsHandler_t uLipeMutexCreateCeiling(uint16_t ceilPrio, OsStatus_t *err);
+
 
 /*!
  * uLipeMutexTake()
- * \brief Take a resource from a mutex, and suspend task if its not available
+ * \brief Take a resource from a mutex, and suspend task if its not available,
+ * the owner can take it again and must give it the same number of times
  * \param
  * \return
  */
@@ -64,9 +71,10 @@ OsStatus_t uLipeMutexTake(OsHandler_t h);
 
 /*!
  * uLipeMutexGive()
- * \brief Release a resource used from a mutex
+ * \brief Release a resource used from a mutex, the caller gets back the
+ * priority required by the mutexes it still holds
  * \param
- * \return
+ * \return kMutexNotOwner if the caller does not hold the mutex
  */
 OsStatus_t uLipeMutexGive(OsHandler_t h);
 
@@ -78,5 +86,25 @@ OsStatus_t uLipeMutexGive(OsHandler_t h);
  */
 OsStatus_t uLipeMutexDelete(OsHandler_t *h);
 
+/*!
+ * uLipeMutexOwnerPrio()
+ * \brief Level a task must run while holding its mutexes, the highest of
+ * its base one, the ceilings and the waiters of them
+ * \param tcb - task to be checked
+ * \return
+ * \note used by kernel, must be called with interrupts disabled
+ */
+uint16_t uLipeMutexOwnerPrio(struct OsTCB_ *tcb);
+
+/*!
+ * uLipeMutexTaskDelete()
+ * \brief Detaches a deleted task from the mutexes, the ones it holds are
+ * given to their waiters and the priority it lent is taken back
+ * \param tcb - task being deleted
+ * \return
+ * \note used by kernel, must be called with interrupts disabled
+ */
+void uLipeMutexTaskDelete(struct OsTCB_ *tcb);
+
 #endif
 #endif
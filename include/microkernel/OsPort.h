@@ -19,10 +19,28 @@
 
 
 /*
- * Enter and exit criticals macro:
+ * Enter and exit criticals macro, on multicore the interrupts of the
+ * calling core are masked and the kernel spinlock is taken:
  */
+#if OS_ARCH_MULTICORE > 0
+#define OS_CRITICAL_IN() 	sReg = uLipeKernelLockIn()
+#define OS_CRITICAL_OUT()   uLipeKernelLockOut(sReg)
+#else
 #define OS_CRITICAL_IN() 	sReg = uLipeEnterCritical()
 #define OS_CRITICAL_OUT()   uLipeExitCritical(sReg)
+#endif
+
+/*
+ * Memory barrier, orders the accesses shared with isrs or other cores
+ * which are done out of critical sections:
+ */
+#ifndef OS_PORT_MEM_BARRIER
+#if OS_ARCH_POSIX == 1
+#define OS_PORT_MEM_BARRIER()	__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define OS_PORT_MEM_BARRIER()	__asm volatile ("dmb" ::: "memory")
+#endif
+#endif
 
 
 /*
@@ -45,6 +63,16 @@ void uLipeInitMachine(void);
  *  \return
  */
 OsStackPtr_t uLipeStackInit(OsStackPtr_t taskStk, void * task, void *taskArgs );
+
+/*!
+ *  uLipePortStackFree()
+ *  \brief Releases the port resources taken by uLipeStackInit() for a
+ *  deleted task
+ *  \param taskStk - stack pointer returned by uLipeStackInit()
+ *  \return
+ */
+void uLipePortStackFree(OsStackPtr_t taskStk);
+
 /*!
  *  uLipePortChange()
  *  \brief request a context change interrupt via pendSv
@@ -66,6 +94,8 @@ extern void uLipePortStartKernel(void);
  *  \brief Shut down interrupts and save status registers
  *  \param
  *  \return
+ *  \note with OS_MAX_SYSCALL_IRQ_PRIO set only the irqs allowed to call
+ *  the kernel are masked
  */
 extern uint32_t uLipeEnterCritical(void);
 
@@ -77,6 +107,66 @@ extern uint32_t uLipeEnterCritical(void);
  */
 extern void uLipeExitCritical(uint32_t sReg);
 
+#if OS_TICKLESS_IDLE_EN > 0
+/*!
+ *  uLipePortTicklessSleep()
+ *  \brief Stops the periodic tick and sleeps up to the amount of ticks
+ *  \param ticks - ticks up to the next timeout expiration
+ *  \return number of whole ticks elapsed while the machine was sleeping
+ *  \note called with interrupts masked, it should return in the same way
+ */
+extern uint32_t uLipePortTicklessSleep(uint32_t ticks);
+#endif
+
+#if OS_ARCH_MULTICORE > 0
+/*!
+ *  uLipePortCoreId()
+ *  \brief Identifies the core executing the caller
+ *  \param
+ *  \return core number, from 0 up to OS_NUMBER_OF_CORES - 1
+ */
+extern uint16_t uLipePortCoreId(void);
+
+/*!
+ *  uLipePortSpinLock()
+ *  \brief Takes the kernel spinlock, shared by all cores
+ *  \param
+ *  \return
+ *  \note called with interrupts of the calling core masked, not recursive
+ */
+extern void uLipePortSpinLock(void);
+
+/*!
+ *  uLipePortSpinUnlock()
+ *  \brief Releases the kernel spinlock
+ *  \param
+ *  \return
+ */
+extern void uLipePortSpinUnlock(void);
+
+/*!
+ *  uLipePortCoreSignal()
+ *  \brief Raises the inter core irq of a core, its handler must call
+ *  uLipeKernelIrqIn() and uLipeKernelIrqOut() so the core reschedules
+ *  \param core - core to be signaled
+ *  \return
+ *  \note the context switch routine of a multicore port must select
+ *  the next task with uLipeKernelCoreNextTask(), holding the kernel
+ *  spinlock until the context of the task switched out is saved
+ */
+extern void uLipePortCoreSignal(uint16_t core);
+#endif
+
+#if OS_CYCLE_COUNTER_EN > 0
+/*!
+ *  uLipePortCycleCount()
+ *  \brief Reads a free running cpu cycle counter
+ *  \param
+ *  \return current cycle count, wraps on 32bit
+ */
+extern uint32_t uLipePortCycleCount(void);
+#endif
+
 /*!
  *  uLipeFisrtSwt()
  *  \brief First switching context routine
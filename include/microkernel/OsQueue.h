@@ -39,6 +39,7 @@ struct queue_
 	uint16_t queueBack;			    //current queue insertion point
 	uint16_t numSlots;				//Number of entries of current queue
 	uint16_t usedSlots;				//Number of current used slots
+	uint16_t itemSize;				//bytes of each copied item, 0 for pointer queues
 
 #if OS_USE_DEPRECATED == 1	
 	uint8_t tasksPending[OS_NUMBER_OF_TASKS]; //Wait list for pending tasks
@@ -46,6 +47,13 @@ struct queue_
 	OsPrioList_t queueInsertWait;
 	OsPrioList_t queueSlotWait;
 #endif
+
+#if OS_SET_MODULE_EN > 0
+	struct objset_ *set;			//set this object is linked to
+#endif
+#if OS_DEFERRED_POST_EN > 0
+	uint32_t deferDrops;			//isr inserts discarded on a full queue
+#endif
 };
 
 typedef struct queue_  Queue_t;
@@ -64,13 +72,72 @@ typedef struct queue_* QueuePtr_t;
  */
 OsHandler_t uLipeQueueCreate(uint32_t slots, OsStatus_t *err);
 
+/*!
+ * uLipeQueueCreateCopy()
+ * \brief Creates a queue which copies its items, the control block and
+ * the items storage are taken from heap as a single block
+ * \param itemSize - bytes of each item, word multiples are copied faster
+ * \param slots - number of items
+ * \return
+ */
+OsHandler_t uLipeQueueCreateCopy(uint32_t itemSize, uint32_t slots, OsStatus_t *err);
+
+/*!
+ * uLipeQueueSend()
+ * \brief Copies an item to the tail of a copy queue, and pend if desired,
+ * the caller buffer can be reused on return
+ * \param item - itemSize bytes to be copied
+ * \param opt - OS_Q_BLOCK_FULL to wait a free slot, OS_Q_NON_BLOCK otherwise
+ * \param timeout - ticks to wait, 0 waits forever
+ * \return kTimeout if no slot was freed in time
+ */
+OsStatus_t uLipeQueueSend(OsHandler_t h, const void *item, uint8_t opt, uint32_t timeout);
+
+/*!
+ * uLipeQueueSendUntil()
+ * \brief Copies an item to the tail of a copy queue, a blocking send waits
+ * for a free slot up to an absolute tick
+ * \param deadline - tick of uLipeKernelTickGet() where the wait fails
+ * \return
+ */
+OsStatus_t uLipeQueueSendUntil(OsHandler_t h, const void *item, uint8_t opt, uint32_t deadline);
+
+/*!
+ * uLipeQueueReceive()
+ * \brief Copies the item on the head of a copy queue and removes it, and
+ * pend if desired
+ * \param item - receives itemSize bytes
+ * \param opt - OS_Q_BLOCK_EMPTY to wait an item, OS_Q_NON_BLOCK otherwise
+ * \param timeout - ticks to wait, 0 waits forever
+ * \return kTimeout if no item arrived in time
+ */
+OsStatus_t uLipeQueueReceive(OsHandler_t h, void *item, uint8_t opt, uint32_t timeout);
+
+/*!
+ * uLipeQueueReceiveUntil()
+ * \brief Copies and removes the item on the head of a copy queue, a
+ * blocking receive waits for an item up to an absolute tick
+ * \param deadline - tick of uLipeKernelTickGet() where the wait fails
+ * \return
+ */
+OsStatus_t uLipeQueueReceiveUntil(OsHandler_t h, void *item, uint8_t opt, uint32_t deadline);
+
 /*!
  * uLipeQueueInsert()
  * \brief Insert data on selected queue, and pend if desired
  * \param
  * \return
  */
-OsStatus_t uLipeQueueInsert(OsHandler_t h, void *data, uint8_t opt, uint16_t timeout);
+OsStatus_t uLipeQueueInsert(OsHandler_t h, void *data, uint8_t opt, uint32_t timeout);
+
+/*!
+ * uLipeQueueInsertUntil()
+ * \brief Insert data on selected queue, a blocking insert waits for a
+ * free slot up to an absolute tick
+ * \param deadline - tick of uLipeKernelTickGet() where the wait fails
+ * \return
+ */
+OsStatus_t uLipeQueueInsertUntil(OsHandler_t h, void *data, uint8_t opt, uint32_t deadline);
 
 /*!
  * uLipeQueueRemove()
@@ -78,7 +145,36 @@ OsStatus_t uLipeQueueInsert(OsHandler_t h, void *data, uint8_t opt, uint16_t tim
  * \param
  * \return
  */
-void *uLipeQueueRemove(OsHandler_t h, uint8_t opt, uint16_t timeout, OsStatus_t *err);
+void *uLipeQueueRemove(OsHandler_t h, uint8_t opt, uint32_t timeout, OsStatus_t *err);
+
+/*!
+ * uLipeQueueRemoveUntil()
+ * \brief remove data from a slot of queue, a blocking remove waits for
+ * data up to an absolute tick
+ * \param deadline - tick of uLipeKernelTickGet() where the wait fails
+ * \return
+ */
+void *uLipeQueueRemoveUntil(OsHandler_t h, uint8_t opt, uint32_t deadline, OsStatus_t *err);
+
+/*!
+ * uLipeQueueInsertN()
+ * \brief Inserts up to n items on a queue at once, a blocking insert waits
+ * only while the queue is full and then inserts as many as fit
+ * \param data - array of n items, none of them can be NULL
+ * \param timeout - ticks to wait, 0 waits forever
+ * \return number of items inserted, the ones left stay on data
+ */
+uint32_t uLipeQueueInsertN(OsHandler_t h, void **data, uint32_t n, uint8_t opt, uint32_t timeout, OsStatus_t *err);
+
+/*!
+ * uLipeQueueRemoveN()
+ * \brief Removes up to n items from a queue at once, a blocking remove waits
+ * only while the queue is empty and then takes all up to n
+ * \param data - receives the items, in insertion order
+ * \param timeout - ticks to wait, 0 waits forever
+ * \return number of items removed
+ */
+uint32_t uLipeQueueRemoveN(OsHandler_t h, void **data, uint32_t n, uint8_t opt, uint32_t timeout, OsStatus_t *err);
 
 /*!
  * uLipeQueueQuery()
@@ -106,6 +202,29 @@ OsStatus_t uLipeQueueFlush(OsHandler_t h);
  */
 OsStatus_t uLipeQueueDelete(OsHandler_t *h);
 
+#if OS_DEFERRED_POST_EN > 0
+/*!
+ * uLipeQueueInsertFromISR()
+ * \brief Insert data on a queue from a isr, the insertion is deferred
+ * until the outermost isr exits, and is discarded if the queue is full
+ * at that time
+ * \note kStatusOk only means the insertion was recorded, the discarded
+ * ones are counted by uLipeQueueDeferDrops()
+ * \param
+ * \return kDeferQueueFull if the insertion could not be recorded
+ */
+OsStatus_t uLipeQueueInsertFromISR(OsHandler_t h, void *data);
+
+/*!
+ * uLipeQueueDeferDrops()
+ * \brief Reads how many insertions done from isr were discarded because
+ * the queue was full when they were executed
+ * \param drops - receives the count
+ * \return
+ */
+OsStatus_t uLipeQueueDeferDrops(OsHandler_t h, uint32_t *drops);
+#endif
+
 #endif
 
 
@@ -0,0 +1,133 @@
+/*!
+ *
+ * 							ULIPE RTOS VERSION 4
+ *
+ *
+ *  \file OsRing.h
+ *
+ *  \brief this file contains the data structures and interface
+ *  for single producer single consumer ring buffers
+ *
+ *	In this file the user will find the data structures, and function
+ *	prototype to create and manage byte ring buffers, a single writer,
+ *	usually an isr, and a single reader moves its own index without
+ *	critical sections, the kernel is only called to wake a reader blocked
+ *	waiting the buffer to reach its watermark.
+ *
+ *  Author: FSN
+ *
+ */
+
+#ifndef __OS_RING_H
+#define __OS_RING_H
+
+/*
+ * Ring buffer control block, the bytes storage follows it:
+ */
+struct ring_
+{
+	volatile uint32_t head;				//free running write index, moved by writer
+	volatile uint32_t tail;				//free running read index, moved by reader
+	uint32_t mask;						//storage size - 1, size is a power of 2
+	uint32_t watermark;					//bytes stored which wake the reader
+	struct OsTCB_ * volatile reader;	//reader blocked on uLipeRingWait()
+};
+
+typedef struct ring_  Ring_t;
+typedef struct ring_* RingPtr_t;
+
+#if OS_RING_MODULE_EN > 0
+
+/*
+ * Function prototypes:
+ */
+
+/*!
+ * uLipeRingCreate()
+ * \brief Creates a ring buffer, the control block and the storage are
+ * taken from heap as a single block
+ * \param size - bytes of storage, must be a power of 2
+ * \param watermark - bytes stored which wake the reader, 1 up to size
+ * \return
+ */
+OsHandler_t uLipeRingCreate(uint32_t size, uint32_t watermark, OsStatus_t *err);
+
+/*!
+ * uLipeRingWrite()
+ * \brief Copies bytes to a ring buffer, only the writer calls it, never
+ * blocks and can be used from interrupts
+ * \param
+ * \return bytes written, less than len if the ring became full
+ */
+uint32_t uLipeRingWrite(OsHandler_t h, const void *data, uint32_t len);
+
+/*!
+ * uLipeRingWriteSpan()
+ * \brief Gives the contiguous free space after the write index, the writer
+ * fills it directly, by dma for example, and publishes it with
+ * uLipeRingWriteCommit()
+ * \param span - receives the start of free space
+ * \return bytes of the span, 0 if the ring is full
+ */
+uint32_t uLipeRingWriteSpan(OsHandler_t h, void **span);
+
+/*!
+ * uLipeRingWriteCommit()
+ * \brief Publishes bytes filled on the span taken from uLipeRingWriteSpan()
+ * \param len - bytes filled, up to the span size
+ * \return
+ */
+OsStatus_t uLipeRingWriteCommit(OsHandler_t h, uint32_t len);
+
+/*!
+ * uLipeRingRead()
+ * \brief Copies and removes bytes from a ring buffer, only the reader
+ * calls it, never blocks
+ * \param
+ * \return bytes read, less than len if the ring became empty
+ */
+uint32_t uLipeRingRead(OsHandler_t h, void *data, uint32_t len);
+
+/*!
+ * uLipeRingReadSpan()
+ * \brief Gives the contiguous bytes stored after the read index, the reader
+ * uses them in place and frees them with uLipeRingReadRelease()
+ * \param span - receives the start of stored bytes
+ * \return bytes of the span, 0 if the ring is empty
+ */
+uint32_t uLipeRingReadSpan(OsHandler_t h, void **span);
+
+/*!
+ * uLipeRingReadRelease()
+ * \brief Frees bytes of the span taken from uLipeRingReadSpan()
+ * \param len - bytes consumed, up to the span size
+ * \return
+ */
+OsStatus_t uLipeRingReadRelease(OsHandler_t h, uint32_t len);
+
+/*!
+ * uLipeRingCount()
+ * \brief Bytes stored on a ring buffer
+ * \param
+ * \return
+ */
+uint32_t uLipeRingCount(OsHandler_t h);
+
+/*!
+ * uLipeRingWait()
+ * \brief Suspends the reader until the ring holds at least its watermark
+ * \param timeout - ticks to wait, 0 waits forever
+ * \return kStatusOk when the watermark is reached, kTimeout otherwise
+ */
+OsStatus_t uLipeRingWait(OsHandler_t h, uint32_t timeout);
+
+/*!
+ * uLipeRingDelete()
+ * \brief Destroy a ring buffer
+ * \param
+ * \return kInvalidParam while the reader waits on it
+ */
+OsStatus_t uLipeRingDelete(OsHandler_t *h);
+
+#endif
+#endif
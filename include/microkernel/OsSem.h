@@ -31,6 +31,10 @@ struct sem_
 #else
 	OsPrioList_t tasksWaiting;
 #endif
+
+#if OS_SET_MODULE_EN > 0
+	struct objset_ *set;					   //set this object is linked to
+#endif
 };
 
 typedef struct sem_  Sem_t;
@@ -57,7 +61,15 @@ OsHandler_t uLipeSemCreate(uint16_t initCount, uint16_t limitCount,OsStatus_t *e
  * \param
  * \return
  */
-OsStatus_t uLipeSemTake(OsHandler_t h, uint16_t timeout);
+OsStatus_t uLipeSemTake(OsHandler_t h, uint32_t timeout);
+
+/*!
+ * uLipeSemTakeUntil()
+ * \brief Take a semaphore, waiting for it up to an absolute tick
+ * \param deadline - tick of uLipeKernelTickGet() where the wait fails
+ * \return kTimeout if the deadline was reached, even before the call
+ */
+OsStatus_t uLipeSemTakeUntil(OsHandler_t h, uint32_t deadline);
 
 /*!
  * uLipeSemGive()
@@ -75,6 +87,17 @@ OsStatus_t uLipeSemGive(OsHandler_t h, uint16_t count);
  */
 OsStatus_t uLipeSemDelete(OsHandler_t *h);
 
+#if OS_DEFERRED_POST_EN > 0
+/*!
+ * uLipeSemGiveFromISR()
+ * \brief Release a semaphore from a isr, the give is deferred until the
+ * outermost isr exits
+ * \param
+ * \return kDeferQueueFull if the post could not be recorded
+ */
+OsStatus_t uLipeSemGiveFromISR(OsHandler_t h, uint16_t count);
+#endif
+
 
 #endif
 #endif
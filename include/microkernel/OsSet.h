@@ -0,0 +1,138 @@
+/*!
+ *
+ * 							ULIPE RTOS VERSION 4
+ *
+ *
+ *  \file OsSet.h
+ *
+ *  \brief this file contains the data structures and interface
+ *  for object sets management
+ *
+ *	In this file the user will find the data structures, and function
+ *	prototype to create and manage object sets, a single task blocks on
+ *	a set of semaphores, queues, flags groups and stream buffers with one
+ *	timeout and is told which of them became ready, then it takes that
+ *	object as usual.
+ *
+ *  Author: FSN
+ *
+ */
+
+#ifndef __OS_SET_H
+#define __OS_SET_H
+
+/*
+ * Set member types:
+ */
+#define OS_SET_SEM		0x01	//ready while the semaphore count is not zero
+#define OS_SET_QUEUE	0x02	//ready while the queue holds an item
+#define OS_SET_FLAGS	0x03	//ready while any flag of the member mask is set
+#define OS_SET_STREAM	0x04	//ready while the stream holds its trigger level
+
+/*
+ * Set member, one for each object linked to the set:
+ */
+struct setmember_
+{
+	OsHandler_t h;				//linked object
+	uint32_t mask;				//flags checked, flags groups only
+	uint8_t type;				//one of member types above
+};
+
+typedef struct setmember_  SetMember_t;
+typedef struct setmember_* SetMemberPtr_t;
+
+/*
+ * Set control block, the members storage follows it:
+ */
+struct objset_
+{
+	struct OsTCB_ *waiter;		//task blocked on uLipeSetWait()
+	uint16_t maxMembers;		//members storage size
+	uint16_t numMembers;		//members linked
+	uint16_t nextMember;		//member checked first, so no member starves
+};
+
+typedef struct objset_  Set_t;
+typedef struct objset_* SetPtr_t;
+
+#if OS_SET_MODULE_EN > 0
+
+/*
+ * Function prototypes:
+ */
+
+/*!
+ * uLipeSetCreate()
+ * \brief Creates an empty object set, the control block and the members
+ * storage are taken from heap as a single block
+ * \param members - max number of objects linked to the set
+ * \return
+ */
+OsHandler_t uLipeSetCreate(uint32_t members, OsStatus_t *err);
+
+/*!
+ * uLipeSetAdd()
+ * \brief Links an object to a set, an object belongs to a single set
+ * \param h - semaphore, queue, flags group or stream buffer handler
+ * \param type - OS_SET_SEM, OS_SET_QUEUE, OS_SET_FLAGS or OS_SET_STREAM
+ * \param mask - flags which make a flags group ready, unused for others
+ * \return kSetFull if there is no free member on set
+ */
+OsStatus_t uLipeSetAdd(OsHandler_t set, OsHandler_t h, uint8_t type, uint32_t mask);
+
+/*!
+ * uLipeSetRemove()
+ * \brief Unlinks an object from a set
+ * \param
+ * \return
+ */
+OsStatus_t uLipeSetRemove(OsHandler_t set, OsHandler_t h);
+
+/*!
+ * uLipeSetWait()
+ * \brief Suspends the task until any object of the set is ready, only one
+ * task waits on a set, the object is not taken, the task takes it after
+ * and does not block while it is still ready
+ * \param timeout - ticks to wait, 0 waits forever
+ * \return handler of the ready object, 0 on timeout
+ */
+OsHandler_t uLipeSetWait(OsHandler_t set, uint32_t timeout, OsStatus_t *err);
+
+/*!
+ * uLipeSetWaitUntil()
+ * \brief Suspends the task until any object of the set is ready up to an
+ * absolute tick
+ * \param deadline - tick of uLipeKernelTickGet() where the wait fails
+ * \return handler of the ready object, 0 on timeout
+ */
+OsHandler_t uLipeSetWaitUntil(OsHandler_t set, uint32_t deadline, OsStatus_t *err);
+
+/*!
+ * uLipeSetDelete()
+ * \brief Unlinks all objects and destroy a set
+ * \param
+ * \return kInvalidParam while a task waits on it
+ */
+OsStatus_t uLipeSetDelete(OsHandler_t *h);
+
+/*!
+ * uLipeSetSignal()
+ * \brief Wakes the task waiting on a set, so it checks the members again
+ * \param
+ * \return
+ * \note called by the member objects with interrupts disabled
+ */
+void uLipeSetSignal(SetPtr_t s);
+
+/*!
+ * uLipeSetDetach()
+ * \brief Unlinks an object from its set
+ * \param
+ * \return
+ * \note called by the member objects with interrupts disabled
+ */
+void uLipeSetDetach(SetPtr_t s, OsHandler_t h);
+
+#endif
+#endif
@@ -0,0 +1,125 @@
+/*!
+ *
+ * 							ULIPE RTOS VERSION 4
+ *
+ *
+ *  \file OsStream.h
+ *
+ *  \brief this file contains the data structures and interface
+ *  for stream buffers management
+ *
+ *	In this file the user will find the data structures, and function
+ *	prototype to create and manage stream buffers, byte rings for
+ *	variable length data like frames or log lines, senders and receivers
+ *	block for space or bytes with a timeout and a reader is only woken
+ *	when the buffer reaches its trigger level.
+ *
+ *  Author: FSN
+ *
+ */
+
+#ifndef __OS_STREAM_H
+#define __OS_STREAM_H
+
+/*
+ * Stream custom codes:
+ */
+#define OS_STREAM_NON_BLOCK		0x00	//moves what is possible and returns
+#define OS_STREAM_BLOCK			0x01	//suspend task waiting space or bytes
+
+/*
+ * Stream buffer control block, the bytes storage follows it:
+ */
+struct stream_
+{
+	uint32_t head;					//free running write index
+	uint32_t tail;					//free running read index
+	uint32_t mask;					//storage size - 1, size is a power of 2
+	uint32_t trigger;				//bytes stored which wake a reader
+	uint32_t readWant;				//shortest read waited, trigger if none
+	OsPrioList_t readWait;			//tasks waiting bytes
+	OsPrioList_t writeWait;			//tasks waiting space
+
+#if OS_SET_MODULE_EN > 0
+	struct objset_ *set;			//set this object is linked to
+#endif
+};
+
+typedef struct stream_  Stream_t;
+typedef struct stream_* StreamPtr_t;
+
+#if OS_STREAM_MODULE_EN > 0
+
+/*
+ * Function prototypes:
+ */
+
+/*!
+ * uLipeStreamCreate()
+ * \brief Creates a stream buffer, the control block and the storage are
+ * taken from heap as a single block
+ * \param size - bytes of storage, must be a power of 2
+ * \param trigger - bytes stored which wake a reader, 1 up to size
+ * \return
+ */
+OsHandler_t uLipeStreamCreate(uint32_t size, uint32_t trigger, OsStatus_t *err);
+
+/*!
+ * uLipeStreamSend()
+ * \brief Copies bytes to a stream buffer, with OS_STREAM_BLOCK the task
+ * waits space until all bytes are copied, can be used from interrupts
+ * with OS_STREAM_NON_BLOCK
+ * \param timeout - ticks to wait, 0 waits forever
+ * \return bytes copied, less than len on timeout or without space
+ */
+uint32_t uLipeStreamSend(OsHandler_t h, const void *data, uint32_t len, uint8_t opt,
+						 uint32_t timeout, OsStatus_t *err);
+
+/*!
+ * uLipeStreamReceive()
+ * \brief Copies and removes bytes from a stream buffer, with OS_STREAM_BLOCK
+ * the task waits the trigger level, or len bytes if less, the bytes
+ * stored when the timeout expires are returned
+ * \param timeout - ticks to wait, 0 waits forever
+ * \return bytes copied, up to len
+ */
+uint32_t uLipeStreamReceive(OsHandler_t h, void *data, uint32_t len, uint8_t opt,
+							uint32_t timeout, OsStatus_t *err);
+
+/*!
+ * uLipeStreamPeek()
+ * \brief Gives the contiguous bytes stored after the read index, the reader
+ * uses them in place and frees them with uLipeStreamConsume()
+ * \param span - receives the start of stored bytes
+ * \return bytes of the span, 0 if the stream is empty
+ */
+uint32_t uLipeStreamPeek(OsHandler_t h, void **span);
+
+/*!
+ * uLipeStreamConsume()
+ * \brief Frees bytes of the span taken from uLipeStreamPeek(), waking a
+ * sender waiting space
+ * \param len - bytes consumed, up to the span size
+ * \return
+ */
+OsStatus_t uLipeStreamConsume(OsHandler_t h, uint32_t len);
+
+/*!
+ * uLipeStreamCount()
+ * \brief Bytes stored on a stream buffer
+ * \param
+ * \return
+ */
+uint32_t uLipeStreamCount(OsHandler_t h);
+
+/*!
+ * uLipeStreamDelete()
+ * \brief Destroy a stream buffer, the tasks waiting on it return from
+ * uLipeStreamSend() or uLipeStreamReceive() with kInvalidParam
+ * \param
+ * \return
+ */
+OsStatus_t uLipeStreamDelete(OsHandler_t *h);
+
+#endif
+#endif
@@ -24,6 +24,14 @@
  *	tasks modules constants
  */
 #define OS_MAX_TASKS		256 //Internal limit of tasks can be created
+#define OS_STACK_PAINT		0xA5A5A5A5 //Unused stack words
+#define OS_STACK_CANARY		0xDEADC0DE //Stack limit word
+
+/*
+ *  budget overrun options:
+ */
+#define OS_BUDGET_THROTTLE	0x00 //suspended until replenishment
+#define OS_BUDGET_DEMOTE	0x01 //runs on OS_BUDGET_DEMOTE_PRIO until replenishment
 
 /*
  *  task status code:
@@ -40,23 +48,93 @@ typedef enum					//
 	kTaskPendSem,				//
 	kTaskPendMtx,				//
 	kTaskPendQueue,				//
+	kTaskPendNotify,			//
+	kTaskPendTimer,				//timer daemon waiting expirations
+	kTaskPendBudget,			//budget exhausted, waiting replenishment
+	kTaskPendRing,				//ring buffer reader waiting its watermark
+	kTaskPendSet,				//waiting any member of an object set
+	kTaskPendStream,			//waiting bytes or space of a stream buffer
 }TaskState_t;
 
+/*
+ *  task notification actions:
+ */
+typedef enum					//
+{								//
+	kNotifySetBits = 0,			//notification value |= value
+	kNotifyIncrement,			//notification value++, value is ignored
+	kNotifyOverwrite,			//notification value = value
+}OsNotifyAction_t;
+
+/*
+ *  task runtime statistics:
+ */
+typedef struct					//
+{								//
+	uint64_t runCycles;			//cpu cycles consumed by the task
+	uint32_t switchCount;		//times the task was switched in
+	uint32_t preemptCount;		//times the task was switched out still ready
+	uint32_t lastRun;			//cycle count of last switch in
+}OsTaskStats_t;
+
 /*
  * 	task control block
  */
 struct OsTCB_
 {
 	OsStackPtr_t stackTop;		//Pointer that contain the current top of stack
+	OsStackPtr_t stackBase;		//Lowest stack address, keep it as second field
 	void        (*task) (void*);//function pointer to task.
-	uint16_t	 taskPrio;		//Id of this tcb, corresponds to its priority
-	uint32_t	 flagsPending;	//flags to pend register
-	uint16_t     delayTime;
-	uint16_t     taskStatus;	//The current status of the task
+	uint16_t	 taskPrio;		//Id of this tcb, its priority is OS_TASK_PRIO(taskPrio)
+	uint16_t	 runPrio;		//Level of its ready fifo, raised while inheriting
+	uint32_t	 flagsPending;	//flags to pend register, the matched ones once woken
+	uint32_t     wakeTick;		//absolute tick of delay expiration
+	uint32_t     taskStatus;	//The current status of the task
+    struct OsTCB_ *timerNext;	//timer wheel bucket links
+    struct OsTCB_ *timerPrev;	//
+    struct OsTCB_ *readyNext;	//ready fifo links
+    struct OsTCB_ *readyPrev;	//
     OsPrioListPtr_t mtxBmp;
     OsPrioListPtr_t flagsBmp;
     OsPrioListPtr_t queueBmp;
     OsPrioListPtr_t semBmp;
+#if OS_STREAM_MODULE_EN > 0
+    OsPrioListPtr_t streamBmp;	//stream list the task waits on
+#endif
+#if OS_MTX_MODULE_EN > 0
+    struct mutex_ *mtxHeld;		//mutexes owned, newest first
+    struct mutex_ *mtxWait;		//mutex the task is blocked on
+#endif
+#if OS_TASK_NOTIFY_EN > 0
+    uint32_t     notifyValue;	//direct to task notification word
+    uint8_t      notifyPending;	//notified since last wait
+#endif
+#if OS_TASK_STATS_EN > 0
+    OsTaskStats_t stats;		//runtime statistics
+#endif
+#if OS_STACK_MONITOR_EN > 0
+    uint32_t     stackSize;		//stack size in words
+#endif
+#if OS_ARCH_MULTICORE > 0
+    uint16_t     coreId;		//core whose ready list holds the task
+    uint32_t     affinity;		//mask of cores allowed to run the task
+#endif
+#if OS_EDF_EN > 0
+    uint32_t     relDeadline;	//deadline after each release, 0 if not edf
+    uint32_t     deadline;		//absolute deadline of current job
+    uint32_t     deadlineMisses;//jobs completed after its deadline
+    uint8_t      jobActive;		//released and not completed yet
+#endif
+#if OS_TASK_BUDGET_EN > 0
+    uint32_t     budget;		//ticks allowed on each period, 0 if not budgeted
+    uint32_t     budgetPeriod;	//ticks between replenishments
+    uint32_t     budgetUsed;	//ticks consumed on current period
+    uint32_t     budgetReplenish;//absolute tick of next replenishment
+    uint32_t     budgetOverruns;//periods where the budget was exhausted
+    uint8_t      budgetOpt;		//overrun option
+    uint8_t      budgetExhausted;//throttled or demoted until replenishment
+    struct OsTCB_ *budgetNext;	//list of budgeted tasks
+#endif
 };
 
 typedef struct OsTCB_ 	OsTCB_t;
@@ -81,6 +159,8 @@ OsStatus_t uLipeTaskInit(void);
  * 	ulipeTaskCreate()
  *
  *  \brief install a task and make it ready to run
+ *  \note the task takes the first free id of taskPrio, it reads its
+ *  id with uLipeTaskSelf()
  *  \param
  *
  *  \return
@@ -89,10 +169,44 @@ OsStatus_t uLipeTaskInit(void);
 OsStatus_t uLipeTaskCreate(void (*task) (void * args), uint32_t stackSize,
 						   uint16_t taskPrio, void *taskArgs);
 
+#if OS_EDF_EN > 0
+/*!
+ * 	ulipeTaskCreateEdf()
+ *
+ *  \brief install a task on the earliest deadline first band, each time
+ *  it becomes ready a job is released with deadline after relDeadline ticks,
+ *  a job completes when the task blocks
+ *  \param relDeadline - relative deadline in ticks, must be > 0
+ *
+ *  \return
+ *
+ */
+OsStatus_t uLipeTaskCreateEdf(void (*task) (void * args), uint32_t stackSize,
+							  uint32_t relDeadline, void *taskArgs);
+
+/*!
+ * 	ulipeTaskDeadlineMisses()
+ *
+ *  \brief Reads how many jobs of an edf task completed after its deadline
+ *  \param taskPrio - id of the task
+ *  \param misses - receives the count
+ *
+ *  \return kInvalidParam if the task is not on edf band
+ *
+ */
+OsStatus_t uLipeTaskDeadlineMisses( uint16_t taskPrio, uint32_t *misses);
+#endif
+
 /*!
  * 	ulipeTaskDelete()
  *
  *  \brief uninstalls a task.
+ *  \note tasks are identified by its id, the n-th task created on a prio
+ *  has the id OS_TASK_ID(prio, n), which is the prio itself if
+ *  OS_TASKS_PER_PRIO is 1
+ *  \note a task deleting itself keeps its memory until the next delete
+ *  done on the same core
+ *  \note the mutexes held by the task are given to their waiters
  *  \param
  *
  *  \return
@@ -100,6 +214,18 @@ OsStatus_t uLipeTaskCreate(void (*task) (void * args), uint32_t stackSize,
  */
 OsStatus_t uLipeTaskDelete( uint16_t taskPrio);
 
+/*!
+ * 	ulipeTaskSelf()
+ *
+ *  \brief Gets the id of the calling task, to be passed to the routines
+ *  which take a task id
+ *  \param
+ *
+ *  \return id of the current task
+ *
+ */
+uint16_t uLipeTaskSelf(void);
+
 /*!
  * 	ulipeTaskSuspend()
  *
@@ -131,6 +257,156 @@ OsStatus_t uLipeTaskResume( uint16_t taskPrio);
  *  \return
  *
  */
-OsStatus_t uLipeTaskDelay( uint16_t ticks);
+OsStatus_t uLipeTaskDelay( uint32_t ticks);
+
+/*!
+ * 	ulipeTaskDelayUntil()
+ *
+ *  \brief Suspends current task until a periodic release tick, the next
+ *  release is taken from the previous one so the period does not drift
+ *  \param lastWake - previous release, initialize it with uLipeKernelTickGet()
+ *  and it is updated to the new release on each call
+ *  \param period - ticks between releases
+ *
+ *  \return kTimeout without suspending if the release was already missed
+ *
+ */
+OsStatus_t uLipeTaskDelayUntil( uint32_t *lastWake, uint32_t period);
+
+#if OS_TASK_NOTIFY_EN > 0
+/*!
+ * 	ulipeTaskNotify()
+ *
+ *  \brief Updates the notification word of a task and wakes it up if it
+ *  is waiting for a notification, no kernel object is needed, can be
+ *  used from interrupts
+ *  \param taskPrio - id of the task to be notified
+ *  \param value - value to be applied
+ *  \param action - how the value updates the notification word
+ *
+ *  \return
+ *
+ */
+OsStatus_t uLipeTaskNotify( uint16_t taskPrio, uint32_t value, OsNotifyAction_t action);
+
+/*!
+ * 	ulipeTaskNotifyWait()
+ *
+ *  \brief Suspends current task until it receives a notification
+ *  \param clearMask - bits of notification word cleared after reading it
+ *  \param value - receives the notification word, can be NULL
+ *  \param timeout - ticks to wait, 0 waits forever
+ *
+ *  \return kStatusOk when notified, kTimeout otherwise
+ *
+ */
+OsStatus_t uLipeTaskNotifyWait( uint32_t clearMask, uint32_t *value, uint32_t timeout);
+
+/*!
+ * 	ulipeTaskNotifyWaitUntil()
+ *
+ *  \brief Suspends current task until it receives a notification or an
+ *  absolute tick is reached
+ *  \param deadline - tick of uLipeKernelTickGet() where the wait fails
+ *
+ *  \return kStatusOk when notified, kTimeout otherwise
+ *
+ */
+OsStatus_t uLipeTaskNotifyWaitUntil( uint32_t clearMask, uint32_t *value, uint32_t deadline);
+#endif
+
+#if OS_STACK_MONITOR_EN > 0
+/*!
+ * 	ulipeTaskStackUsage()
+ *
+ *  \brief Measures the deepest stack usage of a task since its creation
+ *  \param taskPrio - id of the task
+ *  \param used - receives the high water mark, in words
+ *  \param size - receives the stack size in words, can be NULL
+ *
+ *  \return
+ *
+ */
+OsStatus_t uLipeTaskStackUsage( uint16_t taskPrio, uint32_t *used, uint32_t *size);
+#endif
+
+#if OS_TASK_STATS_EN > 0
+/*!
+ * 	ulipeTaskStats()
+ *
+ *  \brief Takes a snapshot of the runtime statistics of a task
+ *  \param taskPrio - id of the task
+ *  \param stats - receives the statistics, the cycles of the current
+ *  task include its ongoing run
+ *
+ *  \return
+ *
+ */
+OsStatus_t uLipeTaskStats( uint16_t taskPrio, OsTaskStats_t *stats);
+#endif
+
+#if OS_ROUND_ROBIN_EN > 0
+/*!
+ * 	ulipeTaskTimeSlice()
+ *
+ *  \brief Sets the round robin quantum of tasks which shares a prio
+ *  \param taskPrio - priority level to be changed
+ *  \param ticks - quantum in ticks, 0 disables the slicing
+ *
+ *  \return
+ *
+ */
+OsStatus_t uLipeTaskTimeSlice( uint16_t taskPrio, uint16_t ticks);
+#endif
+
+#if OS_TASK_BUDGET_EN > 0
+/*!
+ * 	ulipeTaskBudget()
+ *
+ *  \brief Limits the cpu time of a task, each tick spent running is taken
+ *  from its budget and when it is exhausted the task is throttled or
+ *  demoted until the next replenishment period
+ *  \param taskPrio - id of the task, idle tasks cannot be budgeted
+ *  \param budget - ticks allowed on each period, 0 removes the budget
+ *  \param period - ticks between replenishments, must be >= budget
+ *  \param opt - OS_BUDGET_THROTTLE or OS_BUDGET_DEMOTE
+ *
+ *  \return
+ *  \note a throttled task keeps its mutexes, so prefer demotion for tasks
+ *  sharing them
+ *
+ */
+OsStatus_t uLipeTaskBudget( uint16_t taskPrio, uint32_t budget, uint32_t period, uint8_t opt);
+
+/*!
+ * 	ulipeTaskBudgetOverruns()
+ *
+ *  \brief Reads how many periods a task exhausted its budget
+ *  \param taskPrio - id of the task
+ *  \param overruns - receives the count
+ *
+ *  \return kInvalidParam if the task is not budgeted
+ *
+ */
+OsStatus_t uLipeTaskBudgetOverruns( uint16_t taskPrio, uint32_t *overruns);
+#endif
+
+#if OS_ARCH_MULTICORE > 0
+/*!
+ * 	ulipeTaskAffinity()
+ *
+ *  \brief Restricts the cores allowed to run a task, tasks are created
+ *  with OS_CORE_ALL and are placed on the allowed core running the
+ *  lowest priority each time they become ready
+ *  \param taskPrio - id of the task
+ *  \param coreMask - bit n set allows core n
+ *
+ *  \return
+ *  \note a task running on a core no longer allowed moves when it
+ *  becomes ready again
+ *
+ */
+OsStatus_t uLipeTaskAffinity( uint16_t taskPrio, uint32_t coreMask);
+#endif
 
 #endif
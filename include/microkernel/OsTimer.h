@@ -0,0 +1,155 @@
+/*!
+ *
+ * 							ULIPE RTOS VERSION 4
+ *
+ *
+ *  \file OsTimer.h
+ *
+ *  \brief this file contains the data structures and interface
+ *  for software timers management
+ *
+ *	In this file the user will find the data structures, and function
+ *	prototype to create and manage software timers, the expirations are
+ *	found by the kernel tick and the callbacks are called in batches by
+ *	a single timer daemon task.
+ *
+ *  Author: FSN
+ *
+ */
+
+#ifndef __OS_TIMER_H
+#define __OS_TIMER_H
+
+/*
+ * Timer options:
+ */
+#define OS_TIMER_ONE_SHOT	0x00	//stops after the first expiration
+#define OS_TIMER_PERIODIC	0x01	//rearmed at each period
+#define OS_TIMER_HEAP		0x80	//internal, control block from heap
+
+/*
+ * Timer callback, runs on the timer daemon task:
+ */
+typedef void (*OsTimerCallback_t)(OsHandler_t h, void *arg);
+
+/*
+ * Timer states:
+ */
+typedef enum
+{
+	kTimerStopped = 0,
+	kTimerActive,				//waiting its expiration on the wheel
+	kTimerExpired,				//waiting the daemon to call it
+}TimerState_t;
+
+/*
+ * Timer control block:
+ */
+struct timer_
+{
+	struct timer_ *next;		//wheel bucket or daemon list links
+	struct timer_ *prev;		//
+	OsTimerCallback_t callback;	//called on expiration
+	void *arg;					//callback argument
+	uint32_t expiry;			//absolute tick of expiration
+	uint32_t period;			//ticks between expirations
+	uint8_t opt;				//timer options
+	uint8_t state;				//current TimerState_t
+};
+
+typedef struct timer_  Timer_t;
+typedef struct timer_* TimerPtr_t;
+
+#if OS_TIMER_MODULE_EN > 0
+
+/*
+ * Function prototypes:
+ */
+
+/*!
+ * uLipeTimerCreate()
+ * \brief Creates a stopped timer taking its control block from heap
+ * \param callback - function called by the daemon on each expiration
+ * \param arg - callback argument
+ * \param period - ticks from start to expiration, and between periodic ones
+ * \param opt - OS_TIMER_ONE_SHOT or OS_TIMER_PERIODIC
+ * \return
+ */
+OsHandler_t uLipeTimerCreate(OsTimerCallback_t callback, void *arg, uint32_t period,
+							 uint8_t opt, OsStatus_t *err);
+
+/*!
+ * uLipeTimerCreateStatic()
+ * \brief Creates a stopped timer on a control block given by the user
+ * \param t - control block, must live while the timer is used
+ * \return
+ */
+OsHandler_t uLipeTimerCreateStatic(Timer_t *t, OsTimerCallback_t callback, void *arg,
+								   uint32_t period, uint8_t opt, OsStatus_t *err);
+
+/*!
+ * uLipeTimerStart()
+ * \brief Starts a stopped timer, a running one is kept untouched, can be
+ * used from interrupts
+ * \param
+ * \return
+ */
+OsStatus_t uLipeTimerStart(OsHandler_t h);
+
+/*!
+ * uLipeTimerReset()
+ * \brief Restarts a timer counting a full period from now, can be used
+ * from interrupts
+ * \param
+ * \return
+ */
+OsStatus_t uLipeTimerReset(OsHandler_t h);
+
+/*!
+ * uLipeTimerStop()
+ * \brief Stops a timer, an expiration not called yet is discarded, can be
+ * used from interrupts
+ * \param
+ * \return
+ */
+OsStatus_t uLipeTimerStop(OsHandler_t h);
+
+/*!
+ * uLipeTimerDelete()
+ * \brief Stops a timer and frees it when it came from heap
+ * \param
+ * \return
+ */
+OsStatus_t uLipeTimerDelete(OsHandler_t *h);
+
+/*!
+ * uLipeTimerInit()
+ * \brief Clears the timers and installs the timer daemon task, called by
+ * uLipeRtosInit()
+ * \param
+ * \return
+ */
+OsStatus_t uLipeTimerInit(void);
+
+/*!
+ * uLipeTimerTick()
+ * \brief Moves the timers expiring on a tick to the daemon, waking it up
+ * \param tick - tick being accounted
+ * \return
+ * \note called by kernel tick with interrupts disabled
+ */
+void uLipeTimerTick(uint32_t tick);
+
+#if OS_TICKLESS_IDLE_EN > 0
+/*!
+ * uLipeTimerNextTimeout()
+ * \brief Ticks up to the earliest timer expiration
+ * \param
+ * \return OS_TICKLESS_NO_TIMEOUT if no timer is running
+ * \note must be called with interrupts disabled
+ */
+uint32_t uLipeTimerNextTimeout(void);
+#endif
+
+#endif
+#endif
@@ -0,0 +1,134 @@
+/*!
+ *
+ * 							ULIPE RTOS VERSION 4
+ *
+ *
+ *  \file OsTrace.h
+ *
+ *  \brief this file contains the data structures and interface
+ *  of the kernel trace recorder
+ *
+ *	In this file the user will find the trace record format and the
+ *	routines to control the recording, the trace buffer can be dumped
+ *	from ram (osTraceBuffer symbol) and converted by the host decoder
+ *	placed on tools/trace
+ *
+ *  Author: FSN
+ *
+ */
+
+#ifndef __OS_TRACE_H
+#define __OS_TRACE_H
+
+/*
+ * Trace constants:
+ */
+#define OS_TRACE_MAGIC		0x52544C75	//"uLTR" in little endian
+#define OS_TRACE_VERSION	1
+#define OS_TRACE_NO_TASK	0xFFFF		//record made before kernel start
+#define OS_TRACE_MASK		(OS_TRACE_BUFFER_SIZE - 1)
+
+/*
+ *  trace events, the meaning of the argument is commented:
+ */
+typedef enum					//
+{								//
+	kTraceTaskSwitch = 1,		//id of task switched in
+	kTraceTaskReady,			//id of task made ready
+	kTraceTaskBlock,			//id of task removed from ready list
+	kTraceIsrEnter,				//irq nesting level
+	kTraceIsrExit,				//irq nesting level
+	kTraceSemTake,				//semaphore handler
+	kTraceSemGive,				//semaphore handler
+	kTraceQueueInsert,			//queue handler
+	kTraceQueueRemove,			//queue handler
+	kTraceFlagsPend,			//flags handler
+	kTraceFlagsPost,			//flags handler
+	kTraceMutexTake,			//mutex handler
+	kTraceMutexGive,			//mutex handler
+	kTraceMemAlloc,				//requested size
+	kTraceMemFree,				//block address
+}OsTraceEvent_t;
+
+/*
+ * Trace record, fixed size:
+ */
+struct traceRecord_
+{
+	uint32_t timeStamp;			//cpu cycle count
+	uint16_t taskId;			//id of task running when recorded
+	uint8_t  event;				//OsTraceEvent_t
+	uint8_t  reserved;			//
+	uint32_t arg;				//event argument
+};
+
+typedef struct traceRecord_  OsTraceRecord_t;
+typedef struct traceRecord_* OsTraceRecordPtr_t;
+
+/*
+ * Trace ring buffer, the header lets the decoder parse a raw dump:
+ */
+struct traceBuffer_
+{
+	uint32_t magic;				//OS_TRACE_MAGIC
+	uint16_t version;			//OS_TRACE_VERSION
+	uint16_t recordSize;		//sizeof(OsTraceRecord_t)
+	uint32_t size;				//number of records
+	uint32_t head;				//records written, wraps on size
+	uint32_t cpuRate;			//timestamps frequency in Hz
+	OsTraceRecord_t records[OS_TRACE_BUFFER_SIZE];
+};
+
+typedef struct traceBuffer_  OsTraceBuffer_t;
+typedef struct traceBuffer_* OsTraceBufferPtr_t;
+
+#if OS_TRACE_EN > 0
+
+/*
+ * Kernel trace point:
+ */
+#define OS_TRACE(event, arg)	uLipeTraceRecord((event), (uint32_t)(uintptr_t)(arg))
+
+/*
+ * Trace function prototypes:
+ */
+
+/*!
+ * uLipeTraceInit()
+ * \brief Clears the trace buffer and starts the recording
+ * \param
+ * \return
+ */
+void uLipeTraceInit(void);
+
+/*!
+ * uLipeTraceRecord()
+ * \brief Appends a record on trace buffer, overwriting the oldest one
+ * \param event - event to be recorded
+ * \param arg - event argument
+ * \return
+ */
+void uLipeTraceRecord(OsTraceEvent_t event, uint32_t arg);
+
+/*!
+ * uLipeTraceStart()
+ * \brief Resumes the recording
+ * \param
+ * \return
+ */
+void uLipeTraceStart(void);
+
+/*!
+ * uLipeTraceStop()
+ * \brief Freezes the trace buffer, so it can be dumped
+ * \param
+ * \return
+ */
+void uLipeTraceStop(void);
+
+#else
+
+#define OS_TRACE(event, arg)
+
+#endif
+#endif
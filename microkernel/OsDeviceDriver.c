@@ -69,7 +69,7 @@ Device_t* uLipeDeviceOpen(const char *devName, OsStatus_t *err)
 }
 
 
-OsStatus_t uLipeDeviceStartSync(Device_t *dev, uint16_t timeout)
+OsStatus_t uLipeDeviceStartSync(Device_t *dev, uint32_t timeout)
 {
     OsStatus_t ret = kStatusOk;
 
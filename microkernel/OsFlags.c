@@ -36,103 +36,125 @@
 /*
  *  Module external variables
  */
-extern OsTCBPtr_t  tcbPtrTbl[OS_NUMBER_OF_TASKS];		//Array of tcb pointers to external access
-extern OsPrioList_t taskPrioList;					    //Ready task list.
-extern OsTCBPtr_t currentTask;
-extern OsDualPrioList_t timerPendingList;
+extern OsTCBPtr_t  tcbPtrTbl[OS_TASK_SLOTS];		//Array of tcb pointers to external access
 /*
  * Module implementation:
  *
  */
 
 /*
- * FlagsPostLoop()
- * Internal, used to process when all tasks when a flag is asserted
+ * FlagsIndex()
+ *
+ * Internal, puts or takes a task from the list of each flag it pends
  */
-inline static void FlagsPostLoop(OsHandler_t h)
+inline static void FlagsIndex(FlagsGrpPtr_t f, OsTCBPtr_t tcb, bool set)
 {
-	FlagsGrpPtr_t f = (FlagsGrpPtr_t)h;
-	uint16_t i = 0;
-	uint16_t match = FALSE;
-	uint32_t mask  = 0;
-	uint16_t tmp = 0;
+	uint32_t flags = tcb->flagsPending;
+	uint16_t bit;
+
+	while(flags != 0)
+	{
+		bit = OS_KERNEL_ENTRIES_FOR_GROUP - uLipePortBitFSScan(flags);
+		flags &= ~((uint32_t)1 << bit);
+
+		if(set != false) uLipePrioSet(tcb->taskPrio, &f->bitWait[bit]);
+		else uLipePrioClr(tcb->taskPrio, &f->bitWait[bit]);
+	}
+}
 
-	//Search for a match flags:
-	i = uLipeKernelFindHighPrio(&f->waitTasks[f->activeList]);
+/*
+ * FlagsGather()
+ *
+ * Internal, merges the waiters of a group of flags on a single list
+ */
+inline static void FlagsGather(FlagsGrpPtr_t f, uint32_t flags, OsPrioListPtr_t list)
+{
+	uint32_t grp;
+	uint16_t bit;
+	uint16_t x;
+
+	list->prioGrp = 0;
 
-	while(i != 0)
+	while(flags != 0)
 	{
-		//check for pend type of this task:
-		switch(tcbPtrTbl[i]->taskStatus & ((1 << kTaskPendFlagAll) | (1 << kTaskPendFlagAny)))
-		{
-			case (1 << kTaskPendFlagAll):
-			{
-				//Only match if all specific flags are set
-				mask = f->flagRegister & tcbPtrTbl[i]->flagsPending;
-				if(mask == tcbPtrTbl[i]->flagsPending)
-				{
-				    match = TRUE;
-				    tcbPtrTbl[i]->taskStatus &= ~((1 << kTaskPendFlagAll | (1 << kTaskPendDelay)) );
-				}
-			}
-			break;
-
-			case (1 << kTaskPendFlagAny):
-			{
-				//Match if any of flags are set
-				mask = f->flagRegister;
-				if(mask != 0)
-				{
-				    match = TRUE;
-                    tcbPtrTbl[i]->taskStatus &= ~((1 << kTaskPendFlagAny | (1 << kTaskPendDelay)) );
-				}
-			}
-			break;
-
-			default:
-                match = FALSE; //task waiting nothing
-            break;
-		}
+		bit = OS_KERNEL_ENTRIES_FOR_GROUP - uLipePortBitFSScan(flags);
+		flags &= ~((uint32_t)1 << bit);
 
-		//match ocurred?
-		if(match != FALSE)
+		//only the used entries are merged, new ones are copied:
+		grp = f->bitWait[bit].prioGrp;
+		while(grp != 0)
 		{
+			x = OS_KERNEL_ENTRIES_FOR_GROUP - uLipePortBitFSScan(grp);
+			grp &= ~((uint32_t)1 << x);
 
-			//Assert a false for next loop
-			match = FALSE;
-
+			if(list->prioGrp & ((uint32_t)1 << x)) list->prioTbl[x] |= f->bitWait[bit].prioTbl[x];
+			else list->prioTbl[x] = f->bitWait[bit].prioTbl[x];
+		}
+		list->prioGrp |= f->bitWait[bit].prioGrp;
+	}
+}
 
-			//Check if this assert will consume flags:
-			if(tcbPtrTbl[i]->taskStatus & (1 << kTaskPenFlagConsume))
-			{
-				//clear these flags
-				tmp |= mask;
-				tcbPtrTbl[i]->taskStatus &= ~(1 << kTaskPenFlagConsume) ;
-                //If we had a consume event, so clear these flags;
-                f->flagRegister &= ~(tmp);
+/*
+ * FlagsPostLoop()
+ * Internal, used to process the tasks pending the flags just asserted,
+ * tasks which pend none of them are not checked
+ */
+inline static void FlagsPostLoop(OsHandler_t h, uint32_t flags)
+{
+	FlagsGrpPtr_t f = (FlagsGrpPtr_t)h;
+	OsPrioList_t candidates;
+	OsTCBPtr_t tcb;
+	uint32_t match;
+	uint16_t i;
 
-			}
+	FlagsGather(f, flags, &candidates);
 
-            //Make this task as ready:
-            if(tcbPtrTbl[i]->taskStatus == 0) {
-                uLipePrioSet(i, &taskPrioList);
-            }
+	//highest priority first, so it consumes first:
+	while(candidates.prioGrp != 0)
+	{
+		i = uLipeKernelFindHighPrio(&candidates);
+		uLipePrioClr(i, &candidates);
+		tcb = tcbPtrTbl[i];
 
+		match = f->flagRegister & tcb->flagsPending;
+		if(tcb->taskStatus & (1 << kTaskPendFlagAll))
+		{
+			//Only match if all specific flags are set
+			if(match != tcb->flagsPending) continue;
 		}
-		else
+		else if(match == 0)
 		{
-		    /* ensure this flag is waiting for flags */
-		    if(tcbPtrTbl[i]->taskStatus & ((1 << kTaskPendFlagAll) | (1 << kTaskPendFlagAny))) {
-	            uLipePrioSet(i, &f->waitTasks[f->activeList ^ 0x01]);
-		    }
+			continue;
 		}
 
-	    i = uLipeKernelFindHighPrio(&f->waitTasks[f->activeList]);
-	    uLipePrioClr(i, &f->waitTasks[f->activeList]);
+		FlagsIndex(f, tcb, false);
+		uLipeKernelTimerStop(tcb);
+
+		//Check if this assert will consume flags:
+		if(tcb->taskStatus & (1 << kTaskPenFlagConsume))
+		{
+			f->flagRegister &= ~match;
+		}
+
+		//the task gets the flags which released it:
+		tcb->taskStatus &= ~((1 << kTaskPendFlagAll) | (1 << kTaskPendFlagAny) | (1 << kTaskPenFlagConsume));
+		tcb->flagsPending = match;
+		tcb->flagsBmp = NULL;
+
+		//Make this task as ready:
+		if(tcb->taskStatus == 0)
+		{
+			uLipeKernelTaskReady(tcb);
+		}
 	}
 
-	/* swap to new active list */
-	f->activeList ^= 0x01;
+#if OS_SET_MODULE_EN > 0
+	//a task waiting on a set checks it again:
+	if(f->set != NULL)
+	{
+		uLipeSetSignal(f->set);
+	}
+#endif
 }
 
 /*
@@ -145,27 +167,47 @@ inline static void FlagsPostLoop(OsHandler_t h)
 inline static void FlagsDeleteLoop(OsHandler_t h)
 {
 	FlagsGrpPtr_t f = (FlagsGrpPtr_t)h;
-	uint16_t i = 0;
+	OsPrioList_t waiters;
+	OsTCBPtr_t tcb;
+	uint16_t i;
 
-	i = uLipeKernelFindHighPrio(&f->waitTasks[f->activeList]);
-	while( i != 0)
-	{
-        //make this task ready:
-        tcbPtrTbl[i]->taskStatus &= ~((1 << kTaskPendFlagAll) | (1 << kTaskPendFlagAny) | (1 << kTaskPenFlagConsume));
-        if(tcbPtrTbl[i]->taskStatus == 0) uLipePrioSet(i, &taskPrioList);
-        i = uLipeKernelFindHighPrio(&f->waitTasks[f->activeList]);
-        uLipePrioClr(i, &f->waitTasks[f->activeList]);
+	FlagsGather(f, 0xFFFFFFFF, &waiters);
 
+	while(waiters.prioGrp != 0)
+	{
+		i = uLipeKernelFindHighPrio(&waiters);
+		uLipePrioClr(i, &waiters);
+		tcb = tcbPtrTbl[i];
+
+        //make this task ready, with no flags matched:
+        uLipeKernelTimerStop(tcb);
+        tcb->taskStatus &= ~((1 << kTaskPendFlagAll) | (1 << kTaskPendFlagAny) | (1 << kTaskPenFlagConsume));
+        tcb->flagsPending = 0;
+        tcb->flagsBmp = NULL;
+        if(tcb->taskStatus == 0) uLipeKernelTaskReady(tcb);
 	}
 }
 
 
+#if OS_DEFERRED_POST_EN > 0
+/*
+ * FlagsPostDeferred()
+ *
+ * Internal function, executes a post recorded by uLipeFlagsPostFromISR()
+ */
+static void FlagsPostDeferred(OsHandler_t h, uintptr_t arg)
+{
+	uLipeFlagsPost(h, (uint32_t)arg);
+}
+#endif
+
 /*
  * 	uLipeFlagsCreate()
  */
 OsHandler_t uLipeFlagsCreate(OsStatus_t *err)
 {
 	uint32_t sReg = 0;
+	uint32_t i;
 	FlagsGrpPtr_t f = uLipeMemAlloc(sizeof(FlagsGrp_t));
 
 	//Check if we have freeFlags:
@@ -180,10 +222,14 @@ OsHandler_t uLipeFlagsCreate(OsStatus_t *err)
 		return((OsHandler_t)f);
 	}
 
-	f->activeList = 0;
 	f->flagRegister = 0;
-	f->waitTasks[0].prioGrp = 0;
-	f->waitTasks[1].prioGrp = 0;
+	for(i = 0; i < 32; i++)
+	{
+		f->bitWait[i].prioGrp = 0;
+	}
+#if OS_SET_MODULE_EN > 0
+	f->set = NULL;
+#endif
 
 	OS_CRITICAL_OUT();
 
@@ -194,115 +240,81 @@ OsHandler_t uLipeFlagsCreate(OsStatus_t *err)
 }
 
 /*
- *  uLipeFlagsPend()
+ *  uLipeFlagsWait()
+ *
+ *  Internal function, pends for flags up to a relative timeout or up to
+ *  an absolute deadline tick.
  */
-OsStatus_t uLipeFlagsPend(OsHandler_t h, uint32_t flags, uint8_t opt, uint16_t timeout)
+static OsStatus_t uLipeFlagsWait(OsHandler_t h, uint32_t flags, uint8_t opt, uint32_t timeout,
+								 bool deadline, uint32_t *matched)
 {
 	uint32_t sReg = 0;
 	uint32_t mask = 0;
-	uint16_t match = FALSE;
+	uint16_t pend;
 	FlagsGrpPtr_t f = (FlagsGrpPtr_t)h;
 
 
 	//Check for valid handler
-	if(h == 0)
+	if((h == 0) || (flags == 0))
 	{
 		return(kInvalidParam);
 	}
 
-	OS_CRITICAL_IN();
-
-	//Check if this task already asserted:
-	mask = f->flagRegister & currentTask->flagsPending;
-
-
 	//check the pend type:
 	switch(opt & ~(OS_FLAGS_CONSUME))
 	{
 		case OS_FLAGS_PEND_ALL:
-		{
-			if(mask != flags)
-			{
-			    currentTask->taskStatus |= (1 << kTaskPendFlagAll);
-				//check if wants to consume:
-				if(opt & OS_FLAGS_CONSUME)
-				{
-	                currentTask->taskStatus |= (1 << kTaskPenFlagConsume);
-				}
-
-			}
-			else
-			{
-
-                if(opt & OS_FLAGS_CONSUME)
-                {
-                    f->flagRegister &= ~currentTask->flagsPending;
-                }
-
-
-				//The flags of this task is already asserted
-				match = TRUE;
-			}
-		}
+			pend = (1 << kTaskPendFlagAll);
 		break;
 
 		case OS_FLAGS_PEND_ANY:
-		{
-			if(f->flagRegister == 0x0000000)
-			{
-                currentTask->taskStatus |= (1 << kTaskPendFlagAny);
-                //check if wants to consume:
-                if(opt & OS_FLAGS_CONSUME)
-                {
-                    currentTask->taskStatus |= (1 << kTaskPenFlagConsume);
-                }
-			}
-			else
-			{
-                if(opt & OS_FLAGS_CONSUME)
-                {
-                    f->flagRegister = 0;
-                }
-
-				//Any flags of this task was already assert
-				match = TRUE;
-			}
-		}
+			pend = (1 << kTaskPendFlagAny);
 		break;
 
 		default:
-		{
 			//Invalid option, return with error:
-			OS_CRITICAL_OUT();
 			return(kInvalidParam);
-		}
-
 	}
 
-	//check for match:
-	if(match != FALSE)
+	OS_TRACE(kTraceFlagsPend, h);
+
+	OS_CRITICAL_IN();
+
+	//Check if this task already asserted:
+	mask = f->flagRegister & flags;
+	if((pend == (1 << kTaskPendFlagAll)) ? (mask == flags) : (mask != 0))
 	{
+		if(opt & OS_FLAGS_CONSUME)
+		{
+			f->flagRegister &= ~mask;
+		}
 
 		//Only return, without suspend task:
 		OS_CRITICAL_OUT();
 
+		if(matched != NULL) *matched = mask;
 		return(kStatusOk);
 	}
 
-	//Set the flags:
-	currentTask->flagsPending |= flags;
-
-	//if not, then suspend task:
-	uLipePrioClr(currentTask->taskPrio, &taskPrioList);
-	uLipePrioSet(currentTask->taskPrio, &f->waitTasks[f->activeList]);
-	currentTask->flagsBmp = &f->waitTasks[0];
+	//if not, then suspend task on the list of each flag:
+	currentTask->flagsPending = flags;
+	currentTask->taskStatus |= pend;
+	if(opt & OS_FLAGS_CONSUME)
+	{
+		currentTask->taskStatus |= (1 << kTaskPenFlagConsume);
+	}
+	uLipeKernelTaskUnready(currentTask);
+	FlagsIndex(f, currentTask, true);
+	currentTask->flagsBmp = &f->bitWait[0];
 
 	//adds the timeout
-	if(timeout != 0)
+	if(deadline != false)
 	{
-	    currentTask->delayTime  = timeout;
-	    currentTask->taskStatus |= (1 << kTaskPendDelay);
-	    uLipePrioSet(currentTask->taskPrio, &timerPendingList.list[timerPendingList.activeList]);
+	    uLipeKernelTimerStartAt(currentTask, timeout);
+	}
+	else if(timeout != 0)
+	{
+	    uLipeKernelTimerStart(currentTask, timeout);
 	}
 
 	OS_CRITICAL_OUT();
@@ -310,8 +322,35 @@ OsStatus_t uLipeFlagsPend(OsHandler_t h, uint32_t flags, uint8_t opt, uint16_t t
 	//Check for a context switch:
 	uLipeKernelTaskYield();
 
-	//all gone well:
-	return(kStatusOk);
+	//the poster left the flags which released the task:
+	mask = currentTask->flagsPending;
+	if(matched != NULL) *matched = mask;
+
+	return((mask != 0) ? kStatusOk : kTimeout);
+}
+
+/*
+ *  uLipeFlagsPend()
+ */
+OsStatus_t uLipeFlagsPend(OsHandler_t h, uint32_t flags, uint8_t opt, uint32_t timeout)
+{
+	return(uLipeFlagsWait(h, flags, opt, timeout, false, NULL));
+}
+
+/*
+ *  uLipeFlagsPendUntil()
+ */
+OsStatus_t uLipeFlagsPendUntil(OsHandler_t h, uint32_t flags, uint8_t opt, uint32_t deadline)
+{
+	return(uLipeFlagsWait(h, flags, opt, deadline, true, NULL));
+}
+
+/*
+ *  uLipeFlagsPendMatch()
+ */
+OsStatus_t uLipeFlagsPendMatch(OsHandler_t h, uint32_t flags, uint8_t opt, uint32_t timeout, uint32_t *match)
+{
+	return(uLipeFlagsWait(h, flags, opt, timeout, false, match));
 }
 
 /*
@@ -328,6 +367,8 @@ OsStatus_t uLipeFlagsPost(OsHandler_t h, uint32_t flags)
 		return(kInvalidParam);
 	}
 
+	OS_TRACE(kTraceFlagsPost, h);
+
 	//Valid argument, proceed:
 
 
@@ -336,7 +377,7 @@ OsStatus_t uLipeFlagsPost(OsHandler_t h, uint32_t flags)
 	//Assert the flags in register:
 	f->flagRegister |= flags;
 	//Run the PostLoop to update the tasks pending:
-	FlagsPostLoop(h);
+	FlagsPostLoop(h, flags);
 
 	OS_CRITICAL_OUT();
 
@@ -365,6 +406,14 @@ OsStatus_t uLipeFlagsDelete(OsHandler_t *h)
 	//valid argument, then proceed:
 	OS_CRITICAL_IN();
 
+#if OS_SET_MODULE_EN > 0
+	//unlink it from its set:
+	if(((FlagsGrpPtr_t)*h)->set != NULL)
+	{
+		uLipeSetDetach(((FlagsGrpPtr_t)*h)->set, *h);
+	}
+#endif
+
 	//Assert all flag events before to destroy it:
 	FlagsDeleteLoop(*h);
 	uLipeMemFree(f);
@@ -381,4 +430,21 @@ OsStatus_t uLipeFlagsDelete(OsHandler_t *h)
 	return(kStatusOk);
 }
 
+#if OS_DEFERRED_POST_EN > 0
+/*
+ *  uLipeFlagsPostFromISR()
+ */
+OsStatus_t uLipeFlagsPostFromISR(OsHandler_t h, uint32_t flags)
+{
+	//Check argument:
+	if(h == 0)
+	{
+		return(kInvalidParam);
+	}
+
+	//The waiters are processed when the outermost isr exits:
+	return(uLipeKernelDeferPost(&FlagsPostDeferred, h, flags));
+}
+#endif
+
 #endif
@@ -21,169 +21,1197 @@
  * Module Variables:
  */
 
-OsPrioList_t taskPrioList = {0}; 		     //Main installed task priority list
-OsDualPrioList_t timerPendingList = {0};    //timer pending delayed list
+OsPrioList_t taskPrioList[OS_NUMBER_OF_CORES] = {0}; //Main installed task priority list, one for each core
+OsTCBPtr_t   readyQueue[OS_NUMBER_OF_CORES][OS_NUMBER_OF_TASKS] = {0}; //ready tasks fifo, one for each priority
+OsTCBPtr_t   timerWheel[OS_TIMER_WHEEL_SIZE] = {0}; //delayed tasks, hashed by expiration tick
+#if OS_ARCH_MULTICORE > 0
+OsTCBPtr_t   osCoreCurrentTask[OS_NUMBER_OF_CORES];  //tcb being executed by each core
+OsTCBPtr_t   osCoreHighPrioTask[OS_NUMBER_OF_CORES]; //high priority task ready on each core
+static volatile uint16_t kernelLockOwner = OS_CORE_NONE; //core holding the kernel spinlock
+static uint16_t kernelLockNesting;        //kernel lock nesting of its owner
+#else
 OsTCBPtr_t   currentTask = NULL;   	        //pointer to current tcb is being executed
 OsTCBPtr_t   highPrioTask = NULL;		     //pointer to high priority task ready to run
+#endif
+
+
+
+volatile uint32_t tickCounter;    //Incremented every os tick interrupt
+uint8_t  osConfigured = FALSE;
+uint8_t  osRunning = FALSE;				  //Kernel executing flag
+uint16_t irqCounter[OS_NUMBER_OF_CORES];  //Irq nesting counter of each core
+uint16_t schedLock[OS_NUMBER_OF_CORES];   //Scheduler lock nesting counter of each core
+
+#if OS_TASK_STATS_EN > 0
+uint32_t statsSwitchStamp[OS_NUMBER_OF_CORES]; //cycle count of last context switch
+uint64_t statsCycles[OS_NUMBER_OF_CORES];	  //cycles elapsed up to last context switch
+uint64_t statsLoadCycles;		  //cycles elapsed on last cpu load query
+uint64_t statsLoadIdle;			  //idle cycles on last cpu load query
+#endif
+
+#if OS_DEFERRED_POST_EN > 0
+OsDeferred_t deferQueue[OS_DEFER_QUEUE_SIZE];	//Posts recorded by isrs
+uint16_t deferHead;						//deferred queue insertion point
+uint16_t deferTail;						//deferred queue remove point
+#endif
+
+#if OS_ROUND_ROBIN_EN > 0
+uint16_t timeSlice[OS_NUMBER_OF_TASKS];  //Time slice quantum of each priority
+uint16_t sliceTicks[OS_NUMBER_OF_CORES]; //Ticks consumed by current task slice
+#endif
+
+#if OS_TASK_BUDGET_EN > 0
+OsTCBPtr_t budgetList = NULL;			  //Tasks with a cpu budget
+#endif
+
+/*
+ *	External  variables:
+ */
+extern OsTCBPtr_t tcbPtrTbl[];
+
+/*
+ * Internal functions:
+ */
+#if OS_TICKLESS_IDLE_EN > 0
+static void uLipeKernelTicklessIdle(void);
+#endif
+#if OS_DEFERRED_POST_EN > 0
+static void uLipeKernelDeferredDrain(void);
+#endif
+#if OS_ARCH_MULTICORE > 0
+static uint16_t uLipeKernelCoreSelect(struct OsTCB_ *tcb);
+static void uLipeKernelCorePull(uint16_t core);
+#endif
+
+/*
+ *  Kernel functions implementation:
+ */
+
+/*
+ *  uLipeKernelIdleTask()
+ *
+ *  This is the idle task, which run at lhe least priority
+ */
+void uLipeKernelIdleTask(void *args)
+{
+
+	for(;;)
+	{
+#if IDLE_TASK_HOOK_EN > 0
+		//Hook for a user defined callback:
+		IdleTaskHook();
+#endif
+
+#if OS_TICKLESS_IDLE_EN > 0
+		//nothing to do, so sleep until the next timeout:
+		uLipeKernelTicklessIdle();
+#endif
+	}
+}
+
+
+/*
+ * 	uLipeTaskEntry()
+ *
+ * 	This internal function, is used to prepare task to start
+ * 	its execution, and catch possible task return
+ */
+void uLipeTaskEntry(void *args)
+{
+	OsTCBPtr_t tcb;
+	OsStatus_t err;
+
+	//Takes the current task to start execution:
+	tcb = currentTask;
+
+	//start task:
+	tcb->task(args);
+
+	//if this task return, suspend it:
+	if(tcb->taskPrio != 0)
+	{
+		err = uLipeTaskSuspend(tcb->taskPrio);
+		if(err != kStatusOk)
+		{
+			//if cant suspend, task may have some fault, so for safety,
+			//delete it:
+			err = uLipeTaskDelete(tcb->taskPrio);
+
+		}
+	}
+
+	//task trapped for debugf purposes.
+	while(1);
+}
+
+/*
+ * 	uLipeKernelIrqIn()
+ */
+void uLipeKernelIrqIn(void)
+{
+	uint16_t core;
+
+	//should run only if kernel is running:
+	if(osRunning != TRUE)return;
+
+	//isr does not migrate, so its core is stable:
+	core = OS_CORE_ID();
+	if(irqCounter[core] < 0xFFFF) irqCounter[core]++;
+
+	OS_TRACE(kTraceIsrEnter, irqCounter[core]);
+}
+
+/*
+ * 	ulipeKernelIrqOut()
+ */
+void uLipeKernelIrqOut(void)
+{
+	uint32_t sReg = 0;
+	uint16_t core;
+
+	//should run only if kernel is running:
+	if(osRunning != TRUE)return;
+
+	core = OS_CORE_ID();
+	OS_TRACE(kTraceIsrExit, irqCounter[core]);
+
+	OS_CRITICAL_IN();
+	if(irqCounter[core] > 0) irqCounter[core]--;
+	OS_CRITICAL_OUT();
+
+	if(irqCounter[core] == 0)
+	{
+#if OS_DEFERRED_POST_EN > 0
+		//run the posts recorded by all the nested irqs:
+		uLipeKernelDeferredDrain();
+#endif
+
+		//If executed all irqs then request a switch context:
+		uLipeKernelTaskYield();
+	}
+}
+
+#if OS_DEFERRED_POST_EN > 0
+/*
+ * 	uLipeKernelDeferPost()
+ */
+OsStatus_t uLipeKernelDeferPost(OsDeferredFunc_t func, OsHandler_t h, uintptr_t arg)
+{
+	uint32_t sReg = 0;
+	OsDeferredPtr_t d;
+
+	//check arguments:
+	if(func == NULL) return(kInvalidParam);
+
+	OS_CRITICAL_IN();
+
+	//not in a isr, nothing to defer, the counter is read with
+	//interrupts masked so a task cannot migrate meanwhile:
+	if(irqCounter[OS_CORE_ID()] == 0)
+	{
+		OS_CRITICAL_OUT();
+		func(h, arg);
+		return(kStatusOk);
+	}
+
+	if((uint16_t)(deferHead - deferTail) >= OS_DEFER_QUEUE_SIZE)
+	{
+		OS_CRITICAL_OUT();
+		return(kDeferQueueFull);
+	}
+
+	//only records the post, constant time:
+	d = &deferQueue[deferHead & OS_DEFER_QUEUE_MASK];
+	d->func = func;
+	d->h = h;
+	d->arg = arg;
+	deferHead++;
+
+	OS_CRITICAL_OUT();
+
+	return(kStatusOk);
+}
+
+/*
+ * 	uLipeKernelDeferredDrain()
+ *
+ * 	Internal function, executes the deferred posts with interrupts
+ * 	enabled, each record is removed atomically so a nested irq which
+ * 	also drains the queue never executes it twice.
+ */
+static void uLipeKernelDeferredDrain(void)
+{
+	uint32_t sReg = 0;
+	OsDeferred_t d;
+
+	for(;;)
+	{
+		OS_CRITICAL_IN();
+		if(deferTail == deferHead)
+		{
+			OS_CRITICAL_OUT();
+			break;
+		}
+
+		d = deferQueue[deferTail & OS_DEFER_QUEUE_MASK];
+		deferTail++;
+		OS_CRITICAL_OUT();
+
+		d.func(d.h, d.arg);
+	}
+}
+#endif
+
+/*
+ * 	uLipeSchedLock()
+ */
+void uLipeSchedLock(void)
+{
+	uint32_t sReg = 0;
+	uint16_t core;
+
+	OS_CRITICAL_IN();
+	core = OS_CORE_ID();
+	if(schedLock[core] < 0xFFFF) schedLock[core]++;
+	OS_CRITICAL_OUT();
+}
+
+/*
+ * 	uLipeSchedUnlock()
+ */
+void uLipeSchedUnlock(void)
+{
+	uint32_t sReg = 0;
+	uint16_t core;
+	uint16_t locks;
+
+	OS_CRITICAL_IN();
+	core = OS_CORE_ID();
+	if(schedLock[core] > 0) schedLock[core]--;
+	locks = schedLock[core];
+	OS_CRITICAL_OUT();
+
+	if(locks == 0)
+	{
+		//a single scheduling decision for all the batched calls:
+		uLipeKernelTaskYield();
+	}
+}
+
+/*
+ * 	uLipeKernelTickGet()
+ */
+uint32_t uLipeKernelTickGet(void)
+{
+	//a single word read, the tick isr cannot tear it:
+	return(tickCounter);
+}
+
+#if (OS_TASK_STATS_EN > 0) || (OS_TRACE_EN > 0)
+/*
+ * 	uLipeKernelSwitchHook()
+ */
+void uLipeKernelSwitchHook(void)
+{
+	uint16_t core = OS_CORE_ID();
+	OsTCBPtr_t from = OS_CORE_CURRENT(core);
+	OsTCBPtr_t to = OS_CORE_HIGH_PRIO(core);
+#if OS_TASK_STATS_EN > 0
+	uint32_t now;
+	uint32_t elapsed;
+#endif
+
+	(void)core;
+	if(from == to) return;
+
+	OS_TRACE(kTraceTaskSwitch, to->taskPrio);
+
+#if OS_TASK_STATS_EN > 0
+	now = uLipePortCycleCount();
+	elapsed = now - statsSwitchStamp[core];
+
+	//account the task being switched out:
+	from->stats.runCycles += elapsed;
+	if(from->readyNext != NULL)
+	{
+		from->stats.preemptCount++;
+	}
+
+	//and the task being switched in:
+	to->stats.switchCount++;
+	to->stats.lastRun = now;
+
+	statsCycles[core] += elapsed;
+	statsSwitchStamp[core] = now;
+#endif
+}
+#endif
+
+#if OS_TASK_STATS_EN > 0
+/*
+ * 	uLipeKernelCpuLoad()
+ */
+uint16_t uLipeKernelCpuLoad(void)
+{
+	uint32_t sReg = 0;
+	uint32_t now;
+	uint32_t elapsed;
+	uint64_t cycles = 0;
+	uint64_t idle = 0;
+	uint16_t ret = 0;
+	uint16_t core;
+	OsTCBPtr_t tcb;
+
+	OS_CRITICAL_IN();
+	now = uLipePortCycleCount();
+
+	//the idle task of each core takes the first slots, the load is
+	//the average of all the cores:
+	for(core = 0; core < OS_NUMBER_OF_CORES; core++)
+	{
+		elapsed = now - statsSwitchStamp[core];
+		cycles += statsCycles[core] + elapsed;
+
+		tcb = tcbPtrTbl[OS_TASK_ID(OS_LEAST_PRIO, core)];
+		idle += tcb->stats.runCycles;
+		if(OS_CORE_CURRENT(core) == tcb)
+		{
+			idle += elapsed;
+		}
+	}
+
+	if(cycles != statsLoadCycles)
+	{
+		ret = (uint16_t)(10000 - (((idle - statsLoadIdle) * 10000) /
+									(cycles - statsLoadCycles)));
+	}
+
+	statsLoadCycles = cycles;
+	statsLoadIdle = idle;
+
+	OS_CRITICAL_OUT();
+
+	return(ret);
+}
+#endif
+
+/*
+ * 	ulipeKernelFindHighPrio()
+ */
+
+
+#if (OS_FAST_SCHED == 0)
+uint16_t uLipeKernelFindHighPrio(OsPrioListPtr_t prioList)
+{
+	uint16_t x   = 0;
+	uint16_t y   = 0;
+	uint16_t ret = 0;
+
+	//check if argument is valid:
+	if(NULL == prioList) return(OS_INVALID_PRIO);
+
+	//find the x and y priority:
+	x = OS_KERNEL_ENTRIES_FOR_GROUP - uLipePortBitFSScan(prioList->prioGrp);
+	if(x > 32) x = 31;
+	y = OS_KERNEL_ENTRIES_FOR_GROUP - uLipePortBitFSScan(prioList->prioTbl[x]);
+	if(y > 32) y = 31;
+
+	//forms the base priority value:
+	ret = (x << 5) | y;
+	/* wraps the ret with correct value */
+	ret = (ret > (OS_TASK_SLOTS-1)) ? 0 : ret;
+
+	return(ret);
+
+}
+#endif
+
+/*
+ * 	uLipeKernelCoreHighPrio()
+ *
+ * 	Internal function, returns the highest priority task ready on a core,
+ * 	the first one of its priority fifo, on multicore a core left only
+ * 	with its idle task first takes a task waiting on other core.
+ */
+static OsTCBPtr_t uLipeKernelCoreHighPrio(uint16_t core)
+{
+	uint16_t prio = 0;
+
+#if OS_ARCH_MULTICORE > 0
+	if(uLipeKernelFindHighPrio(&taskPrioList[core]) == OS_LEAST_PRIO)
+	{
+		uLipeKernelCorePull(core);
+	}
+#endif
+
+	//find the new highest prio ready to run:
+	prio = uLipeKernelFindHighPrio(&taskPrioList[core]);
+
+	//the priority should not be invalid
+	uLipeAssert(prio != OS_INVALID_PRIO);
+	uLipeAssert(readyQueue[core][prio] != NULL);
+
+	return(readyQueue[core][prio]);
+}
+
+/*
+ * 	ulipeKernelTaskYield()
+ */
+void uLipeKernelTaskYield(void)
+{
+	uint32_t sReg = 0;
+	uint16_t core;
+
+	//should run only if kernel running:
+	if(osRunning != TRUE) return;
+
+	//the ready queues may change under an interrupt, so take the
+	//snapshot of the new highest priority task atomically:
+	OS_CRITICAL_IN();
+	core = OS_CORE_ID();
+
+	// interrupts to treat or scheduler locked, the switch is done on
+	// last irq exit or unlock:
+	if((irqCounter[core] > 0) || (schedLock[core] > 0))
+	{
+		OS_CRITICAL_OUT();
+		return;
+	}
+
+	OS_CORE_HIGH_PRIO(core) = uLipeKernelCoreHighPrio(core);
+
+	//check if a context switch is nedded:
+	if(OS_CORE_HIGH_PRIO(core) != OS_CORE_CURRENT(core))
+	{
+		uLipePortChange();
+	}
+
+	OS_CRITICAL_OUT();
+}
+
+#if OS_EDF_EN > 0
+/*
+ * 	uLipeKernelEdfBefore()
+ *
+ * 	Internal function, order of the edf band, tasks without deadline there,
+ * 	lent by a mutex, go first and the others by its absolute deadline.
+ */
+static bool uLipeKernelEdfBefore(struct OsTCB_ *a, struct OsTCB_ *b)
+{
+	if(a->relDeadline == 0) return(b->relDeadline != 0);
+	if(b->relDeadline == 0) return(false);
+
+	return((int32_t)(a->deadline - b->deadline) < 0);
+}
+#endif
+
+/*
+ * 	uLipeKernelCoreInsert()
+ *
+ * 	Internal function, puts a task on the ready fifo of a core.
+ */
+static void uLipeKernelCoreInsert(struct OsTCB_ *tcb, uint16_t core)
+{
+	uint16_t prio = tcb->runPrio;
+	OsTCBPtr_t head = readyQueue[core][prio];
+	OsTCBPtr_t next;
+
+	if(head == NULL)
+	{
+		//first ready task of this priority:
+		tcb->readyNext = tcb;
+		tcb->readyPrev = tcb;
+		readyQueue[core][prio] = tcb;
+		uLipePrioSet(prio, &taskPrioList[core]);
+	}
+	else
+	{
+		//tasks of same priority are served in fifo order, so the
+		//task goes before the head, on the tail of the ring:
+		next = head;
+
+#if OS_EDF_EN > 0
+		//edf band is sorted instead, its head has the earliest deadline:
+		if(prio == OS_EDF_PRIO)
+		{
+			while(uLipeKernelEdfBefore(tcb, next) == false)
+			{
+				next = next->readyNext;
+				if(next == head) break;
+			}
+			if(uLipeKernelEdfBefore(tcb, head)) readyQueue[core][prio] = tcb;
+		}
+#endif
+
+		tcb->readyNext = next;
+		tcb->readyPrev = next->readyPrev;
+		next->readyPrev->readyNext = tcb;
+		next->readyPrev = tcb;
+	}
+
+#if OS_ARCH_MULTICORE > 0
+	tcb->coreId = core;
+
+	//preempts the task running on other core, the calling core
+	//checks its own ready list on the next yield:
+	if((osRunning == TRUE) && (core != OS_CORE_ID()) &&
+	   ((prio > osCoreCurrentTask[core]->runPrio) ||
+	    ((prio == osCoreCurrentTask[core]->runPrio) && (prio == OS_EDF_PRIO) &&
+	     (OS_EDF_EN > 0) && (readyQueue[core][prio] == tcb))))
+	{
+		uLipePortCoreSignal(core);
+	}
+#endif
+}
+
+/*
+ * 	uLipeKernelTaskReady()
+ */
+void uLipeKernelTaskReady(struct OsTCB_ *tcb)
+{
+	//task already on ready list:
+	if(tcb->readyNext != NULL) return;
+
+	OS_TRACE(kTraceTaskReady, tcb->taskPrio);
+
+#if OS_EDF_EN > 0
+	//an edf task without a pending job releases a new one:
+	if((tcb->relDeadline != 0) && (tcb->jobActive == FALSE))
+	{
+		tcb->deadline = tickCounter + tcb->relDeadline;
+		tcb->jobActive = TRUE;
+	}
+#endif
+
+#if OS_ARCH_MULTICORE > 0
+	uLipeKernelCoreInsert(tcb, uLipeKernelCoreSelect(tcb));
+#else
+	uLipeKernelCoreInsert(tcb, 0);
+#endif
+}
+
+/*
+ * 	uLipeKernelCoreRemove()
+ *
+ * 	Internal function, takes a task out of the ready fifo of its core.
+ */
+static void uLipeKernelCoreRemove(struct OsTCB_ *tcb, uint16_t core)
+{
+	uint16_t prio = tcb->runPrio;
+
+	if(tcb->readyNext == tcb)
+	{
+		//last ready task of this priority:
+		readyQueue[core][prio] = NULL;
+		uLipePrioClr(prio, &taskPrioList[core]);
+	}
+	else
+	{
+		tcb->readyPrev->readyNext = tcb->readyNext;
+		tcb->readyNext->readyPrev = tcb->readyPrev;
+		if(readyQueue[core][prio] == tcb) readyQueue[core][prio] = tcb->readyNext;
+	}
+
+	tcb->readyNext = NULL;
+	tcb->readyPrev = NULL;
+}
+
+/*
+ * 	uLipeKernelTaskUnready()
+ */
+void uLipeKernelTaskUnready(struct OsTCB_ *tcb)
+{
+#if OS_ARCH_MULTICORE > 0
+	uint16_t core = tcb->coreId;
+#else
+	uint16_t core = 0;
+#endif
+
+	//task not on ready list:
+	if(tcb->readyNext == NULL) return;
+
+	OS_TRACE(kTraceTaskBlock, tcb->taskPrio);
+
+#if OS_EDF_EN > 0
+	//the running job blocks by itself, so it is completed, a throttled
+	//one is only preempted:
+	if((tcb->relDeadline != 0) && (tcb == OS_CORE_CURRENT(OS_CORE_ID())) &&
+	   ((tcb->taskStatus & (1 << kTaskPendBudget)) == 0))
+	{
+		if((int32_t)(tickCounter - tcb->deadline) > 0) tcb->deadlineMisses++;
+		tcb->jobActive = FALSE;
+	}
+#endif
+
+	uLipeKernelCoreRemove(tcb, core);
+
+#if OS_ARCH_MULTICORE > 0
+	//the task is running or about to run on other core, which must
+	//select another one:
+	if((core != OS_CORE_ID()) &&
+	   ((osCoreCurrentTask[core] == tcb) || (osCoreHighPrioTask[core] == tcb)))
+	{
+		uLipePortCoreSignal(core);
+	}
+#endif
+}
+
+/*
+ * 	uLipeKernelTaskPrioSet()
+ */
+void uLipeKernelTaskPrioSet(struct OsTCB_ *tcb, uint16_t prio)
+{
+#if OS_ARCH_MULTICORE > 0
+	uint16_t core = tcb->coreId;
+#else
+	uint16_t core = 0;
+#endif
+
+	if(tcb->runPrio == prio) return;
+
+	//a blocked task just takes the new level when it becomes ready:
+	if(tcb->readyNext == NULL)
+	{
+		tcb->runPrio = prio;
+		return;
+	}
+
+	//a ready task moves to the new level keeping its core:
+	uLipeKernelCoreRemove(tcb, core);
+	tcb->runPrio = prio;
+	uLipeKernelCoreInsert(tcb, core);
+
+#if OS_ARCH_MULTICORE > 0
+	//other core may need to preempt the task lowered there:
+	if(core != OS_CORE_ID()) uLipePortCoreSignal(core);
+#endif
+}
+
+/*
+ * 	uLipeKernelTaskBasePrio()
+ */
+uint16_t uLipeKernelTaskBasePrio(struct OsTCB_ *tcb)
+{
+	uint16_t prio = OS_TASK_PRIO(tcb->taskPrio);
+
+#if OS_TASK_BUDGET_EN > 0
+	//never raised by the demotion:
+	if((tcb->budgetExhausted != FALSE) && (tcb->budgetOpt & OS_BUDGET_DEMOTE) &&
+	   (OS_BUDGET_DEMOTE_PRIO < prio))
+	{
+		prio = OS_BUDGET_DEMOTE_PRIO;
+	}
+#endif
+
+	return(prio);
+}
+
+#if OS_ARCH_MULTICORE > 0
+/*
+ * 	uLipeKernelLockIn()
+ */
+uint32_t uLipeKernelLockIn(void)
+{
+	uint32_t sReg = uLipeEnterCritical();
+	uint16_t core = OS_CORE_ID();
+
+	//the owner core may nest the lock, the other ones spin with
+	//their interrupts masked:
+	if(kernelLockOwner != core)
+	{
+		uLipePortSpinLock();
+		kernelLockOwner = core;
+	}
+	kernelLockNesting++;
+
+	return(sReg);
+}
+
+/*
+ * 	uLipeKernelLockOut()
+ */
+void uLipeKernelLockOut(uint32_t sReg)
+{
+	uLipeAssert(kernelLockOwner == OS_CORE_ID());
+
+	kernelLockNesting--;
+	if(kernelLockNesting == 0)
+	{
+		kernelLockOwner = OS_CORE_NONE;
+		uLipePortSpinUnlock();
+	}
+
+	//a switch requested by this core is taken here, out of the lock:
+	uLipeExitCritical(sReg);
+}
+
+/*
+ * 	uLipeKernelCurrentTask()
+ */
+struct OsTCB_ *uLipeKernelCurrentTask(void)
+{
+	uint32_t sReg;
+	OsTCBPtr_t ret;
+
+	//only the local interrupts are masked, so the caller is not
+	//switched out between reading the core id and its entry:
+	sReg = uLipeEnterCritical();
+	ret = osCoreCurrentTask[OS_CORE_ID()];
+	uLipeExitCritical(sReg);
+
+	return(ret);
+}
+
+/*
+ * 	uLipeKernelCoreNextTask()
+ */
+struct OsTCB_ *uLipeKernelCoreNextTask(void)
+{
+	uint16_t core = OS_CORE_ID();
+
+	//the ready list may have changed since the switch was requested,
+	//so the core doing it selects again:
+	osCoreHighPrioTask[core] = uLipeKernelCoreHighPrio(core);
+
+	return(osCoreHighPrioTask[core]);
+}
+
+/*
+ * 	uLipeKernelCoreSelect()
+ *
+ * 	Internal function, places a task becoming ready, a task still running
+ * 	stays on its core, otherwise it goes to the allowed core with the
+ * 	lowest priority ready, the last core of the task wins the ties.
+ */
+static uint16_t uLipeKernelCoreSelect(struct OsTCB_ *tcb)
+{
+	uint16_t core;
+	uint16_t prio;
+	uint16_t lowest = OS_INVALID_PRIO;
+	uint16_t ret = tcb->coreId;
+
+	for(core = 0; core < OS_NUMBER_OF_CORES; core++)
+	{
+		//its context is not saved until its core switches it out:
+		if(osCoreCurrentTask[core] == tcb) return(core);
+
+		if((tcb->affinity & (1UL << core)) == 0) continue;
+
+		prio = uLipeKernelFindHighPrio(&taskPrioList[core]);
+		if((prio < lowest) || ((prio == lowest) && (core == tcb->coreId)))
+		{
+			lowest = prio;
+			ret = core;
+		}
+	}
+
+	return(ret);
+}
+
+/*
+ * 	uLipeKernelCorePull()
+ *
+ * 	Internal function, called when a core is left only with its idle
+ * 	task, moves to it the highest priority task waiting on the ready
+ * 	list of other core, tasks running or selected there are skipped.
+ */
+static void uLipeKernelCorePull(uint16_t core)
+{
+	OsPrioList_t ready;
+	OsTCBPtr_t tcb;
+	OsTCBPtr_t best = NULL;
+	uint16_t bestPrio = OS_LEAST_PRIO;
+	uint16_t prio;
+	uint16_t k;
+
+	for(k = 0; k < OS_NUMBER_OF_CORES; k++)
+	{
+		if(k == core) continue;
+
+		//walks the levels of that core from the highest one, only
+		//the ones above the best found are worth to visit:
+		ready = taskPrioList[k];
+		prio = uLipeKernelFindHighPrio(&ready);
+		while(prio > bestPrio)
+		{
+			tcb = readyQueue[k][prio];
+			do
+			{
+				if((tcb != osCoreCurrentTask[k]) && (tcb != osCoreHighPrioTask[k]) &&
+				   ((tcb->affinity & (1UL << core)) != 0))
+				{
+					best = tcb;
+					bestPrio = prio;
+					break;
+				}
+				tcb = tcb->readyNext;
+			}while(tcb != readyQueue[k][prio]);
+
+			uLipePrioClr(prio, &ready);
+			prio = uLipeKernelFindHighPrio(&ready);
+		}
+	}
+
+	if(best != NULL)
+	{
+		uLipeKernelTaskUnready(best);
+		uLipeKernelCoreInsert(best, core);
+	}
+}
+#endif
 
+#if OS_ROUND_ROBIN_EN > 0
+/*
+ * 	uLipeKernelTimeSlice()
+ *
+ * 	Internal function, accounts a tick on the slice of the task running
+ * 	on a core, when it expires the task goes to the tail of its fifo.
+ */
+static void uLipeKernelTimeSlice(uint16_t core)
+{
+	OsTCBPtr_t tcb = OS_CORE_CURRENT(core);
+	uint16_t prio = tcb->runPrio;
 
+	//only slices when there are other ready tasks with same priority:
+	if((timeSlice[prio] == 0) || (readyQueue[core][prio] != tcb) ||
+	   (tcb->readyNext == tcb))
+	{
+		sliceTicks[core] = 0;
+		return;
+	}
 
-volatile uint32_t tickCounter;    //Incremented every os tick interrupt
-uint8_t  osConfigured = FALSE;
-uint8_t  osRunning = FALSE;				  //Kernel executing flag
-uint16_t irqCounter;     		  //Irq nesting counter
+#if OS_EDF_EN > 0
+	//deadlines order the edf band, not the quantum:
+	if(prio == OS_EDF_PRIO)
+	{
+		sliceTicks[core] = 0;
+		return;
+	}
+#endif
+
+	sliceTicks[core]++;
+	if(sliceTicks[core] >= timeSlice[prio])
+	{
+		sliceTicks[core] = 0;
+		readyQueue[core][prio] = tcb->readyNext;
+
+#if OS_ARCH_MULTICORE > 0
+		//the core taking the tick reschedules on its irq exit:
+		if(core != OS_CORE_ID()) uLipePortCoreSignal(core);
+#endif
+	}
+}
+#endif
 
+#if OS_TASK_BUDGET_EN > 0
 /*
- *	External  variables:
+ * 	uLipeKernelBudgetLevel()
+ *
+ * 	Internal function, moves a task to its base level, priorities lent
+ * 	by the mutexes it holds are kept.
  */
-extern OsTCBPtr_t tcbPtrTbl[];
+static void uLipeKernelBudgetLevel(struct OsTCB_ *tcb)
+{
+#if OS_MTX_MODULE_EN > 0
+	uLipeKernelTaskPrioSet(tcb, uLipeMutexOwnerPrio(tcb));
+#else
+	uLipeKernelTaskPrioSet(tcb, uLipeKernelTaskBasePrio(tcb));
+#endif
+}
 
 /*
- *  Kernel functions implementation:
+ * 	uLipeKernelBudgetExhaust()
+ *
+ * 	Internal function, a task used all its budget, it is throttled or
+ * 	demoted up to the next replenishment.
  */
+static void uLipeKernelBudgetExhaust(struct OsTCB_ *tcb)
+{
+	tcb->budgetOverruns++;
+	tcb->budgetExhausted = TRUE;
+
+#if OS_BUDGET_HOOK_EN > 0
+	//Hook for a user defined callback:
+	BudgetOverrunHook(tcb->taskPrio);
+#endif
+
+	if(tcb->budgetOpt & OS_BUDGET_DEMOTE)
+	{
+		uLipeKernelBudgetLevel(tcb);
+	}
+	else
+	{
+		tcb->taskStatus |= (1 << kTaskPendBudget);
+		uLipeKernelTaskUnready(tcb);
+	}
+}
 
 /*
- *  uLipeKernelIdleTask()
+ * 	uLipeKernelBudgetRestore()
  *
- *  This is the idle task, which run at lhe least priority
+ * 	Internal function, gives back to an exhausted task its level or
+ * 	takes it out of the throttling.
  */
-void uLipeKernelIdleTask(void *args)
+static void uLipeKernelBudgetRestore(struct OsTCB_ *tcb)
 {
+	tcb->budgetExhausted = FALSE;
 
-	for(;;)
+	if(tcb->budgetOpt & OS_BUDGET_DEMOTE)
 	{
-#if IDLE_TASK_HOOK_EN > 0
-		//Hook for a user defined callback:
-		IdleTaskHook();
-#endif
+		uLipeKernelBudgetLevel(tcb);
+	}
+	else
+	{
+		tcb->taskStatus &= ~(1 << kTaskPendBudget);
+		if(tcb->taskStatus == 0)
+		{
+			uLipeKernelTaskReady(tcb);
+		}
 	}
 }
 
-
 /*
- * 	uLipeTaskEntry()
+ * 	uLipeKernelBudgetCharge()
  *
- * 	This internal function, is used to prepare task to start
- * 	its execution, and catch possible task return
+ * 	Internal function, takes the elapsed tick from the budget of the task
+ * 	running on a core.
  */
-void uLipeTaskEntry(void *args)
+static void uLipeKernelBudgetCharge(uint16_t core)
 {
-	OsTCBPtr_t tcb;
-	OsStatus_t err;
+	OsTCBPtr_t tcb = OS_CORE_CURRENT(core);
 
-	//Takes the current task to start execution:
-	tcb = currentTask;
+	//a task blocking right now is not throttled, it is left to its object:
+	if((tcb->budget == 0) || (tcb->budgetExhausted != FALSE) || (tcb->readyNext == NULL))
+	{
+		return;
+	}
 
-	//start task:
-	tcb->task(args);
+	tcb->budgetUsed++;
+	if(tcb->budgetUsed >= tcb->budget)
+	{
+		uLipeKernelBudgetExhaust(tcb);
+	}
+}
 
-	//if this task return, suspend it:
-	if(tcb->taskPrio != 0)
+/*
+ * 	uLipeKernelBudgetReplenish()
+ *
+ * 	Internal function, refills the budgets whose period ends on the
+ * 	current tick.
+ */
+static void uLipeKernelBudgetReplenish(void)
+{
+	OsTCBPtr_t tcb;
+
+	for(tcb = budgetList; tcb != NULL; tcb = tcb->budgetNext)
 	{
-		err = uLipeTaskSuspend(tcb->taskPrio);
-		if(err != kStatusOk)
-		{
-			//if cant suspend, task may have some fault, so for safety,
-			//delete it:
-			err = uLipeTaskDelete(tcb->taskPrio);
+		if(tcb->budgetReplenish != tickCounter) continue;
 
+		tcb->budgetReplenish += tcb->budgetPeriod;
+		tcb->budgetUsed = 0;
+		if(tcb->budgetExhausted != FALSE)
+		{
+			uLipeKernelBudgetRestore(tcb);
 		}
 	}
-
-	//task trapped for debugf purposes.
-	while(1);
 }
 
 /*
- * 	uLipeKernelIrqIn()
+ * 	uLipeKernelBudgetSet()
  */
-void uLipeKernelIrqIn(void)
+void uLipeKernelBudgetSet(struct OsTCB_ *tcb, uint32_t budget, uint32_t period, uint8_t opt)
 {
-	//should run only if kernel is running:
-	if(osRunning != TRUE)return;
+	OsTCBPtr_t *link;
+
+	if(tcb->budgetExhausted != FALSE)
+	{
+		uLipeKernelBudgetRestore(tcb);
+	}
+
+	//only budgeted tasks are visited by the tick:
+	if((tcb->budget == 0) && (budget != 0))
+	{
+		tcb->budgetNext = budgetList;
+		budgetList = tcb;
+	}
+	else if((tcb->budget != 0) && (budget == 0))
+	{
+		link = &budgetList;
+		while(*link != tcb)
+		{
+			link = &(*link)->budgetNext;
+		}
+		*link = tcb->budgetNext;
+		tcb->budgetNext = NULL;
+	}
 
-	if(irqCounter < 0xFFFF) irqCounter++;
+	tcb->budget = budget;
+	tcb->budgetPeriod = period;
+	tcb->budgetOpt = opt;
+	tcb->budgetUsed = 0;
+	tcb->budgetReplenish = tickCounter + period;
 }
+#endif
 
 /*
- * 	ulipeKernelIrqOut()
+ * 	uLipeKernelTimerExpire()
+ *
+ * 	Internal function, wakes a task whose timeout expired.
  */
-void uLipeKernelIrqOut(void)
+static void uLipeKernelTimerExpire(struct OsTCB_ *tcb)
 {
-	//should run only if kernel is running:
-	if(osRunning != TRUE)return;
+	uint32_t flags;
+	uint16_t bit;
 
-	if(irqCounter > 0) irqCounter--;
+	uLipeKernelTimerStop(tcb);
 
-	if(irqCounter == 0)
+	//make this task ready and if pending another object
+	//discard it
+	tcb->taskStatus = 0;
+	if(tcb->mtxBmp != NULL)
 	{
-		//If executed all irqs then request a switch context:
-		uLipeKernelTaskYield();
+		uLipePrioClr(tcb->taskPrio, tcb->mtxBmp);
+		tcb->mtxBmp = NULL;
+
+	}
+
+	/* flags has a special acess case, the task is on the list of each
+	 * flag it pends, no flags matched tells a timeout */
+	if(tcb->flagsBmp != NULL)
+	{
+		flags = tcb->flagsPending;
+		while(flags != 0)
+		{
+			bit = OS_KERNEL_ENTRIES_FOR_GROUP - uLipePortBitFSScan(flags);
+			flags &= ~((uint32_t)1 << bit);
+			uLipePrioClr(tcb->taskPrio, tcb->flagsBmp + bit);
+		}
+		tcb->flagsPending = 0;
+		tcb->flagsBmp = NULL;
+	}
+
+	if(tcb->queueBmp != NULL)
+	{
+		uLipePrioClr(tcb->taskPrio, tcb->queueBmp);
+		tcb->queueBmp = NULL;
+	}
+
+	if(tcb->semBmp != NULL)
+	{
+		uLipePrioClr(tcb->taskPrio, tcb->semBmp);
+		tcb->semBmp= NULL;
+
+	}
+
+#if OS_STREAM_MODULE_EN > 0
+	if(tcb->streamBmp != NULL)
+	{
+		uLipePrioClr(tcb->taskPrio, tcb->streamBmp);
+		tcb->streamBmp = NULL;
 	}
+#endif
+
+	uLipeKernelTaskReady(tcb);
 }
 
 /*
- * 	ulipeKernelFindHighPrio()
+ * 	uLipeKernelTimerStart()
  */
+void uLipeKernelTimerStart(struct OsTCB_ *tcb, uint32_t ticks)
+{
+	OsTCBPtr_t *bucket;
+	OsTCBPtr_t prev = NULL;
+	OsTCBPtr_t next;
 
+	uLipeAssert(ticks != 0);
 
-#if (OS_FAST_SCHED == 0)
-uint16_t uLipeKernelFindHighPrio(OsPrioListPtr_t prioList)
-{
-	uint16_t x   = 0;
-	uint16_t y   = 0;
-	uint16_t ret = 0;
+	//expiration is kept as absolute tick:
+	tcb->wakeTick = tickCounter + ticks;
+	tcb->taskStatus |= (1 << kTaskPendDelay);
 
-	//check if argument is valid:
-	if(NULL == prioList) return(OS_INVALID_PRIO);
+	//each bucket is sorted by the distance to expiration:
+	bucket = &timerWheel[tcb->wakeTick & OS_TIMER_WHEEL_MASK];
+	next = *bucket;
+	while((next != NULL) && ((next->wakeTick - tickCounter) <= ticks))
+	{
+		prev = next;
+		next = next->timerNext;
+	}
 
-	//find the x and y priority:
-	x = OS_KERNEL_ENTRIES_FOR_GROUP - uLipePortBitFSScan(prioList->prioGrp);
-	if(x > 32) x = 31;
-	y = OS_KERNEL_ENTRIES_FOR_GROUP - uLipePortBitFSScan(prioList->prioTbl[x]);
-	if(y > 32) y = 31;
+	tcb->timerPrev = prev;
+	tcb->timerNext = next;
+	if(next != NULL) next->timerPrev = tcb;
+	if(prev != NULL) prev->timerNext = tcb;
+	else *bucket = tcb;
+}
 
-	//forms the base priority value:
-	ret = (x << 5) | y;
-	/* wraps the ret with correct value */
-	ret = (ret > (OS_NUMBER_OF_TASKS-1)) ? 0 : ret;
+/*
+ * 	uLipeKernelTimerStartAt()
+ */
+void uLipeKernelTimerStartAt(struct OsTCB_ *tcb, uint32_t wakeTick)
+{
+	uint32_t ticks = wakeTick - tickCounter;
 
-	return(ret);
+	//the tick counter wraps, deadlines beyond the window are in the past:
+	if((ticks == 0) || (ticks > OS_DEADLINE_WINDOW))
+	{
+		uLipeKernelTimerExpire(tcb);
+		return;
+	}
 
+	uLipeKernelTimerStart(tcb, ticks);
 }
-#endif
 
 /*
- * 	ulipeKernelTaskYield()
+ * 	uLipeKernelTimerStop()
  */
-void uLipeKernelTaskYield(void)
+void uLipeKernelTimerStop(struct OsTCB_ *tcb)
 {
-	uint16_t prio = 0;
+	//not in the wheel, nothing to do:
+	if((tcb->taskStatus & (1 << kTaskPendDelay)) == 0) return;
 
-	//should run only if kernel running:
-	if(osRunning != TRUE) return;
+	if(tcb->timerNext != NULL) tcb->timerNext->timerPrev = tcb->timerPrev;
+	if(tcb->timerPrev != NULL) tcb->timerPrev->timerNext = tcb->timerNext;
+	else timerWheel[tcb->wakeTick & OS_TIMER_WHEEL_MASK] = tcb->timerNext;
 
-	// interrupts to treat? abort!
-	if(irqCounter > 0) return;
+	tcb->timerNext = NULL;
+	tcb->timerPrev = NULL;
+	tcb->taskStatus &= ~(1 << kTaskPendDelay);
+}
 
-	//find the new highest prio ready to run:
-	prio = uLipeKernelFindHighPrio(&taskPrioList);
+/*
+ * 	uLipeKernelTimerProcess()
+ *
+ * 	Internal function, accounts a number of elapsed ticks, for each tick
+ * 	only the wheel bucket of that tick is visited and only the tasks
+ * 	which expires on it are touched and made ready.
+ */
+static void uLipeKernelTimerProcess(uint32_t ticks)
+{
+	OsTCBPtr_t *bucket;
 
-	//the priority should not be invalid
-	uLipeAssert(prio != OS_INVALID_PRIO);
-	uLipeAssert(tcbPtrTbl[prio] != NULL);
+	while(ticks != 0)
+	{
+		tickCounter++;
+		ticks--;
 
-	//access the desired tcb:
-	highPrioTask = tcbPtrTbl[prio];
+		bucket = &timerWheel[tickCounter & OS_TIMER_WHEEL_MASK];
 
+		//bucket is sorted, tasks of next wheel turns stays on its tail:
+		while((*bucket != NULL) && ((*bucket)->wakeTick == tickCounter))
+		{
+			uLipeKernelTimerExpire(*bucket);
+		}
 
+#if OS_TIMER_MODULE_EN > 0
+		//software timers of this tick go to its daemon:
+		uLipeTimerTick(tickCounter);
+#endif
 
-	//check if a context switch is nedded:
-	if(highPrioTask != currentTask)
-	{
-		uLipePortChange();
+#if OS_TASK_BUDGET_EN > 0
+		uLipeKernelBudgetReplenish();
+#endif
 	}
-
 }
 
 /*
@@ -191,88 +1219,146 @@ void uLipeKernelTaskYield(void)
  */
 void uLipeKernelRtosTick(void)
 {
-	uint16_t i = 0;
+	uint32_t sReg = 0;
+#if (OS_ROUND_ROBIN_EN > 0) || (OS_TASK_BUDGET_EN > 0)
+	uint16_t core;
+#endif
 
 	if(osRunning != TRUE)return;
 
 	uLipeKernelIrqIn();
-	//start always from the start of tasklist:
-
-
-	i = uLipeKernelFindHighPrio(&timerPendingList.list[timerPendingList.activeList]);
-
-	if(i != 0)
-	{
-	    //proccess tick delays for all installed tasks:
-	    do
-	    {
-	        OsTCBPtr_t tcb = tcbPtrTbl[i];
-	        uLipePrioClr(i, &timerPendingList.list[timerPendingList.activeList]);
-
-	        uLipeAssert(tcb->delayTime > 0);
-
-            //goto to next task:
-	        if(tcb->delayTime != 0)
-	        {
-	            tcb->delayTime--;
-
-	            //Delay time reached to 0:
-	            if(tcb->delayTime == 0)
-	            {
-	                //make this task ready and if pending another object
-	                //discard it
-	                tcb->taskStatus = 0;
-                    if(tcb->mtxBmp != NULL)
-                    {
-                        uLipePrioClr(tcb->taskPrio, tcb->mtxBmp);
-                        tcb->mtxBmp = NULL;
-
-                    }
-
-                    /* flags has a special acess case */
-	                if(tcb->flagsBmp != NULL)
-	                {
-	                    uLipePrioClr(tcb->taskPrio, tcb->flagsBmp);
-                        uLipePrioClr(tcb->taskPrio, tcb->flagsBmp + sizeof(OsPrioList_t));
-                        tcb->flagsBmp = NULL;
-	                }
-
-	                if(tcb->queueBmp != NULL)
-	                {
-                        uLipePrioClr(tcb->taskPrio, tcb->queueBmp);
-                        tcb->queueBmp = NULL;
-	                }
-
-                    if(tcb->semBmp != NULL)
-                    {
-                        uLipePrioClr(tcb->taskPrio, tcb->semBmp);
-                        tcb->semBmp= NULL;
-
-                    }
-
-	                uLipePrioSet(tcb->taskPrio, &taskPrioList);
-	            }
-	            else if((tcb->taskStatus & (1 << kTaskPendDelay)) == 0)
-	            {
-	                (void)0;
-	            }
-	            else
-	            {
-	                //task does not reached to it delay value, move its tcb to backup list
-	                uLipePrioSet(i, &timerPendingList.list[timerPendingList.activeList ^ 0x01]);
-	            }
-	        }
-
-	        i = uLipeKernelFindHighPrio(&timerPendingList.list[timerPendingList.activeList]);
-	    }while(i != 0);
-	    timerPendingList.activeList ^= 0x01;
+
+	//higher priority isrs or other cores may be using the wheel
+	//and ready lists:
+	OS_CRITICAL_IN();
+
+#if OS_TASK_BUDGET_EN > 0
+	//the elapsed tick belongs to the period ending now, so it is
+	//charged before the replenishment:
+	for(core = 0; core < OS_NUMBER_OF_CORES; core++)
+	{
+		uLipeKernelBudgetCharge(core);
+	}
+#endif
+
+	uLipeKernelTimerProcess(1);
+
+#if OS_ROUND_ROBIN_EN > 0
+	for(core = 0; core < OS_NUMBER_OF_CORES; core++)
+	{
+		uLipeKernelTimeSlice(core);
 	}
+#endif
 
+	OS_CRITICAL_OUT();
 
 	//find the next task ready to run:
 	uLipeKernelIrqOut();
 }
 
+#if OS_TICKLESS_IDLE_EN > 0
+/*
+ * 	uLipeKernelNextTimeout()
+ *
+ * 	Internal function, returns the amount of ticks up to the earliest
+ * 	delay expiration, OS_TICKLESS_NO_TIMEOUT if no task is delayed.
+ */
+static uint32_t uLipeKernelNextTimeout(void)
+{
+	uint32_t ret = OS_TICKLESS_NO_TIMEOUT;
+	uint32_t distance;
+	uint32_t i;
+	OsTCBPtr_t tcb;
+
+	//walks one wheel turn, the first bucket which expires on its
+	//own tick holds the earliest timeout:
+	for(i = 1; i <= OS_TIMER_WHEEL_SIZE; i++)
+	{
+	    tcb = timerWheel[(tickCounter + i) & OS_TIMER_WHEEL_MASK];
+	    if(tcb == NULL) continue;
+
+	    distance = tcb->wakeTick - tickCounter;
+	    if(distance == i) return(distance);
+
+	    //expires only on next turns, keep the nearest:
+	    if(distance < ret) ret = distance;
+	}
+
+	return(ret);
+}
+
+#if OS_TASK_BUDGET_EN > 0
+/*
+ * 	uLipeKernelBudgetNextTimeout()
+ *
+ * 	Internal function, returns the amount of ticks up to the earliest
+ * 	replenishment of a throttled task.
+ */
+static uint32_t uLipeKernelBudgetNextTimeout(void)
+{
+	uint32_t ret = OS_TICKLESS_NO_TIMEOUT;
+	uint32_t distance;
+	OsTCBPtr_t tcb;
+
+	for(tcb = budgetList; tcb != NULL; tcb = tcb->budgetNext)
+	{
+		if((tcb->taskStatus & (1 << kTaskPendBudget)) == 0) continue;
+
+		distance = tcb->budgetReplenish - tickCounter;
+		if(distance < ret) ret = distance;
+	}
+
+	return(ret);
+}
+#endif
+
+/*
+ * 	uLipeKernelTicklessIdle()
+ *
+ * 	Internal function, called by idle task, stops the periodic tick and
+ * 	let the port sleep until the earliest delay expiration, when the
+ * 	machine wakes up the elapsed ticks are accounted at once.
+ */
+static void uLipeKernelTicklessIdle(void)
+{
+	uint32_t sReg = 0;
+	uint32_t ticks = 0;
+#if (OS_TIMER_MODULE_EN > 0) || (OS_TASK_BUDGET_EN > 0)
+	uint32_t timerTicks;
+#endif
+
+	OS_CRITICAL_IN();
+
+	ticks = uLipeKernelNextTimeout();
+
+#if OS_TIMER_MODULE_EN > 0
+	//software timers must also wake the machine up:
+	timerTicks = uLipeTimerNextTimeout();
+	if(timerTicks < ticks) ticks = timerTicks;
+#endif
+
+#if OS_TASK_BUDGET_EN > 0
+	//and the throttled tasks:
+	timerTicks = uLipeKernelBudgetNextTimeout();
+	if(timerTicks < ticks) ticks = timerTicks;
+#endif
+
+	//only worth to stop the tick if idle will run for a while:
+	if((ticks >= OS_TICKLESS_MIN_IDLE_TICKS) && (highPrioTask == currentTask))
+	{
+	    ticks = uLipePortTicklessSleep(ticks);
+
+	    //catch up the ticks which elapsed while sleeping:
+	    uLipeKernelTimerProcess(ticks);
+	}
+
+	OS_CRITICAL_OUT();
+
+	//some delayed task may be expired, check for it:
+	uLipeKernelTaskYield();
+}
+#endif
+
 /*
  *
  *
@@ -347,20 +1433,48 @@ void uLipeKernelExecption(void)
 	while(1);
 }
 
+#if OS_STACK_OVERFLOW_CHECK_EN > 0
+void uLipeKernelStackOverflow(struct OsTCB_ *tcb)
+{
+	/* the task overran its stack, memory below it may be corrupted,
+	 * so traps here, tcb points to the offending task */
+	(void)tcb;
+	uLipeKernelExecption();
+}
+#endif
+
 /*
  * 	ulipeRtosInit()
  */
 OsStatus_t uLipeRtosInit(void)
 {
 	uint16_t err;
+	uint16_t core;
+#if OS_ROUND_ROBIN_EN > 0
+	uint16_t prio;
+#endif
 
 	//put all local variables in known state:
-	currentTask  = NULL;
-	highPrioTask = NULL;
 	tickCounter = 0x0000;
 	osRunning = FALSE;
-	irqCounter = 0x0000;
 
+	for(core = 0; core < OS_NUMBER_OF_CORES; core++)
+	{
+		OS_CORE_CURRENT(core)  = NULL;
+		OS_CORE_HIGH_PRIO(core) = NULL;
+		irqCounter[core] = 0x0000;
+		schedLock[core] = 0x0000;
+#if OS_ROUND_ROBIN_EN > 0
+		sliceTicks[core] = 0;
+#endif
+	}
+
+#if OS_ROUND_ROBIN_EN > 0
+	for(prio = 0; prio < OS_NUMBER_OF_TASKS; prio++)
+	{
+		timeSlice[prio] = OS_TIME_SLICE_TICKS;
+	}
+#endif
 
 	err = uLipeMemInit();
     uLipeAssert(err == kStatusOk);
@@ -368,10 +1482,28 @@ OsStatus_t uLipeRtosInit(void)
 	//init low level hardware
 	uLipeInitMachine();
 
-	//Install idle task:
-	err = uLipeTaskCreate(&uLipeKernelIdleTask, OS_IDLE_TASK_STACK_SIZE,
-						  OS_LEAST_PRIO, 0);
+#if OS_TRACE_EN > 0
+	//cycle counter is running, start recording:
+	uLipeTraceInit();
+#endif
+
+	//Install idle task, one for each core on the least prio slots:
+	for(core = 0; core < OS_NUMBER_OF_CORES; core++)
+	{
+		err = uLipeTaskCreate(&uLipeKernelIdleTask, OS_IDLE_TASK_STACK_SIZE,
+							  OS_LEAST_PRIO, 0);
+		uLipeAssert(err == kStatusOk);
+
+#if OS_ARCH_MULTICORE > 0
+		err = uLipeTaskAffinity(OS_TASK_ID(OS_LEAST_PRIO, core), 1UL << core);
+		uLipeAssert(err == kStatusOk);
+#endif
+	}
+
+#if OS_TIMER_MODULE_EN > 0
+	err = uLipeTimerInit();
 	uLipeAssert(err == kStatusOk);
+#endif
 
 #if OS_USE_DEVICE_DRIVERS > 0
 	uLipeDeviceTblInit();
@@ -392,14 +1524,26 @@ OsStatus_t uLipeRtosInit(void)
  */
 OsStatus_t uLipeRtosStart(void)
 {
+	uint16_t core;
+
 	//check if os was pre configured:
 	if(osConfigured != TRUE) return(kKernelStartFail);
 
-	//Find the first task to run:
-	highPrioTask = tcbPtrTbl[uLipeKernelFindHighPrio(&taskPrioList)];
+	//Find the first task to run on each core:
+	for(core = 0; core < OS_NUMBER_OF_CORES; core++)
+	{
+		OS_CORE_HIGH_PRIO(core) = uLipeKernelCoreHighPrio(core);
+
+		//check for problems:
+		uLipeAssert(OS_CORE_HIGH_PRIO(core) != NULL);
 
-	//check for problems:
-	uLipeAssert(highPrioTask != NULL);
+#if OS_TASK_STATS_EN > 0
+		//the first task is switched in now:
+		statsSwitchStamp[core] = uLipePortCycleCount();
+		OS_CORE_HIGH_PRIO(core)->stats.switchCount++;
+		OS_CORE_HIGH_PRIO(core)->stats.lastRun = statsSwitchStamp[core];
+#endif
+	}
 
 #if OS_CONSOLE_CONFIG_VALID > 0
 	uLipePrintk("*** uLipeRTOS started! \n\r");
@@ -482,6 +482,8 @@ void *uLipeMemAlloc(size_t size)
 
 	OS_CRITICAL_OUT();
 
+	OS_TRACE(kTraceMemAlloc, size);
+
 
 
     return ret;
@@ -494,6 +496,7 @@ void uLipeMemFree(void *mem)
 
     if (mem != NULL)
     {
+		OS_TRACE(kTraceMemFree, mem);
 		OS_CRITICAL_IN();
         free_ex(mem, OsCoreMemory);
 		OS_CRITICAL_OUT();
@@ -19,29 +19,162 @@
 
 #if OS_MTX_MODULE_EN > 0
 
-#define mutexTCB tcbPtrTbl[OS_MUTEX_PRIO]
-
 /*
  * External module variables
  */
-extern OsTCBPtr_t currentTask;
 extern OsTCBPtr_t tcbPtrTbl[];
-extern OsPrioList_t taskPrioList;
 
 /*
  * Module implementation:
  */
 
 /*
- * uLipeMutexInit()
+ * uLipeMutexWaitersPrio()
+ *
+ * Internal function, highest priority of the tasks waiting a mutex, they
+ * may be inheriting too, so each one is visited.
  */
+static uint16_t uLipeMutexWaitersPrio(MutexPtr_t m)
+{
+	OsPrioList_t waiters = m->tasksPending;
+	uint16_t prio = 0;
+	uint16_t id;
+
+	while(waiters.prioGrp != 0)
+	{
+		id = uLipeKernelFindHighPrio(&waiters);
+		uLipePrioClr(id, &waiters);
+		if(tcbPtrTbl[id]->runPrio > prio) prio = tcbPtrTbl[id]->runPrio;
+	}
+
+	return(prio);
+}
 
 /*
- * uLipeMutexCreate()
+ * uLipeMutexOwnerPrio()
  */
-OsHandler_t uLipeMutexCreate(OsStatus_t *err)
+uint16_t uLipeMutexOwnerPrio(struct OsTCB_ *tcb)
+{
+	uint16_t prio = uLipeKernelTaskBasePrio(tcb);
+	uint16_t waitPrio;
+	MutexPtr_t m;
+
+	for(m = tcb->mtxHeld; m != NULL; m = m->heldNext)
+	{
+		if(m->ceilPrio > prio) prio = m->ceilPrio;
+
+		waitPrio = uLipeMutexWaitersPrio(m);
+		if(waitPrio > prio) prio = waitPrio;
+	}
+
+	return(prio);
+}
+
+/*
+ * uLipeMutexBoost()
+ *
+ * Internal function, lends a priority to the owner of a mutex, if the owner
+ * is also blocked on a mutex the priority goes along the chain of owners.
+ */
+static void uLipeMutexBoost(MutexPtr_t m, uint16_t prio)
+{
+	OsTCBPtr_t owner;
+
+	//stops on the first owner already high enough, so a deadlock
+	//cycle is walked at most once:
+	while(m != NULL)
+	{
+		owner = tcbPtrTbl[m->mutexOwner];
+		if(owner->runPrio >= prio) break;
+
+		uLipeKernelTaskPrioSet(owner, prio);
+		m = owner->mtxWait;
+	}
+}
+
+/*
+ * uLipeMutexAcquire()
+ *
+ * Internal function, gives a free mutex to a task.
+ */
+static void uLipeMutexAcquire(MutexPtr_t m, OsTCBPtr_t tcb)
 {
-	MutexPtr_t m = uLipeMemAlloc(sizeof(Mutex_t));
+	m->mutexOwner = tcb->taskPrio;
+	m->mutexTaken = 1;
+	m->heldNext = tcb->mtxHeld;
+	tcb->mtxHeld = m;
+}
+
+/*
+ * uLipeMutexRelease()
+ *
+ * Internal function, removes a mutex from the list of its owner.
+ */
+static void uLipeMutexRelease(MutexPtr_t m, OsTCBPtr_t tcb)
+{
+	MutexPtr_t *link = &tcb->mtxHeld;
+
+	//mutexes are mostly given in reverse order, so it is often the head:
+	while(*link != m)
+	{
+		link = &(*link)->heldNext;
+	}
+	*link = m->heldNext;
+	m->heldNext = NULL;
+}
+
+/*
+ * uLipeMutexHandOff()
+ *
+ * Internal function, gives a released mutex to the highest priority task
+ * waiting for it, or frees it if there is none.
+ */
+static void uLipeMutexHandOff(MutexPtr_t m)
+{
+	OsTCBPtr_t next;
+
+	//Check if have items on wait list:
+	if(m->tasksPending.prioGrp != 0)
+	{
+	    //so, take the new owner of mutex:
+		next = tcbPtrTbl[uLipeKernelFindHighPrio(&m->tasksPending)];
+		uLipePrioClr(next->taskPrio, &m->tasksPending);
+		next->mtxBmp = NULL;
+		next->mtxWait = NULL;
+		uLipeMutexAcquire(m, next);
+
+		//the remaining waiters now lend their priority to it:
+		uLipeKernelTaskPrioSet(next, uLipeMutexOwnerPrio(next));
+
+		//Make new owner ready:
+	    next->taskStatus &= ~( 1 << kTaskPendMtx);
+	    if(next->taskStatus == 0)
+	    {
+	        uLipeKernelTaskReady(next);
+	    }
+	}
+	else
+	{
+		//If no tasks pending, so release mutex:
+		m->mutexOwner = 0;
+	}
+}
+
+/*
+ * uLipeMutexCreateCeiling()
+ */
+OsHandler_t uLipeMutexCreateCeiling(uint16_t ceilPrio, OsStatus_t *err)
+{
+	MutexPtr_t m;
+
+	//check arguments:
+	if(ceilPrio > (OS_NUMBER_OF_TASKS - 1))
+	{
+	    if(err != NULL) *err = kInvalidParam;
+		return((OsHandler_t)NULL);
+	}
+
+	m = uLipeMemAlloc(sizeof(Mutex_t));
 
 	//check if we have available mutex:
 	if(m == NULL)
@@ -50,8 +183,10 @@ OsHandler_t uLipeMutexCreate(OsStatus_t *err)
 		return((OsHandler_t)m);
 	}
 	m->mutexOwner = 0;
-	m->mutexTaken = FALSE;
-	m->tasksPending.prioGrp = 0;
+	m->mutexTaken = 0;
+	m->ceilPrio = ceilPrio;
+	m->heldNext = NULL;
+	memset(&m->tasksPending, 0, sizeof(OsPrioList_t));
 
 
 	//Every mutex contro block starts fully initialized.
@@ -59,6 +194,14 @@ OsHandler_t uLipeMutexCreate(OsStatus_t *err)
 	return((OsHandler_t)m);
 }
 
+/*
+ * uLipeMutexCreate()
+ */
+OsHandler_t uLipeMutexCreate(OsStatus_t *err)
+{
+	return(uLipeMutexCreateCeiling(0, err));
+}
+
 
 /*
  * uLipeMutexTake()
@@ -67,6 +210,7 @@ OsStatus_t uLipeMutexTake(OsHandler_t h)
 {
 	uint32_t sReg = 0;
 	MutexPtr_t m = (MutexPtr_t)h;
+	OsTCBPtr_t tcb;
 
 	//Check arguments:
 	if(h == 0)
@@ -74,53 +218,50 @@ OsStatus_t uLipeMutexTake(OsHandler_t h)
 		return(kInvalidParam);
 	}
 
+	OS_TRACE(kTraceMutexTake, h);
+
 	//Argument valid, then proceed:
 	OS_CRITICAL_IN();
+	tcb = currentTask;
 
-	//check if our mutex is already busy:
-	if(m->mutexTaken != FALSE)
+	//if resource available, then give it to caller task:
+	if(m->mutexTaken == 0)
 	{
-		//Add a new task to wait list:
-		uLipePrioSet(currentTask->taskPrio, &m->tasksPending);
-
-		//Suspend current task execution:
-		uLipePrioClr(currentTask->taskPrio, &taskPrioList);
-		currentTask->taskStatus |= (1 << kTaskPendMtx);
-		currentTask->mtxBmp = &m->tasksPending;
-
+		uLipeMutexAcquire(m, tcb);
+		if(m->ceilPrio > tcb->runPrio)
+		{
+			uLipeKernelTaskPrioSet(tcb, m->ceilPrio);
+		}
 		OS_CRITICAL_OUT();
-
-		//Check for new task to execute:
-		uLipeKernelTaskYield();
-
-		return(kMutexOwned);
+		return(kStatusOk);
 	}
 
+	//recursive take by the owner:
+	if(tcbPtrTbl[m->mutexOwner] == tcb)
+	{
+		m->mutexTaken++;
+		OS_CRITICAL_OUT();
+		return(kStatusOk);
+	}
 
-	//if resource available, then give it to caller task:
-	m->mutexTaken = TRUE;
-	OS_CRITICAL_OUT();
-
-	//change this task prio:
-	m->mutexOwner = currentTask->taskPrio;
+	//Add a new task to wait list:
+	uLipePrioSet(tcb->taskPrio, &m->tasksPending);
 
-	OS_CRITICAL_IN();
-	mutexTCB = currentTask;
-	mutexTCB->taskPrio = OS_MUTEX_PRIO;
+	//Suspend current task execution:
+	uLipeKernelTaskUnready(tcb);
+	tcb->taskStatus |= (1 << kTaskPendMtx);
+	tcb->mtxBmp = &m->tasksPending;
+	tcb->mtxWait = m;
 
-	//Make mutex prio ready to run:
-    mutexTCB->taskStatus &= ~( 1 << kTaskPendMtx);
-    if(mutexTCB->taskStatus == 0)
-    {
-        uLipePrioSet(OS_MUTEX_PRIO, &taskPrioList);
-    }
+	//owner runs at least on our priority until it gives the mutex:
+	uLipeMutexBoost(m, tcb->runPrio);
 
 	OS_CRITICAL_OUT();
 
-	//request a context switch
+	//Check for new task to execute:
 	uLipeKernelTaskYield();
 
-	//all gone well:
+	//the giver handed the mutex to us:
 	return(kStatusOk);
 }
 
@@ -132,6 +273,7 @@ OsStatus_t uLipeMutexGive(OsHandler_t h)
 {
 	uint32_t sReg = 0;
 	MutexPtr_t m = (MutexPtr_t)h;
+	OsTCBPtr_t tcb;
 
 	//check arguments:
 	if( h == 0)
@@ -139,53 +281,31 @@ OsStatus_t uLipeMutexGive(OsHandler_t h)
 		return(kInvalidParam);
 	}
 
+	OS_TRACE(kTraceMutexGive, h);
+
 	//Arguments valid, then proceed:
 	OS_CRITICAL_IN();
+	tcb = currentTask;
 
-	//Suspend mutex task:
-	uLipePrioClr(mutexTCB->taskPrio, &taskPrioList);
-	mutexTCB->taskStatus &= ~( 1 << kTaskPendMtx);
-
-	//swap priorities:
-	tcbPtrTbl[m->mutexOwner]->taskPrio = m->mutexOwner;
-
-	//remove the current owner of mutex pending list:
-	uLipePrioClr(m->mutexOwner, &m->tasksPending);
-
-
-	//Check if have items on wait list:
-	if(m->tasksPending.prioGrp != 0)
+	//only the owner can give it:
+	if((m->mutexTaken == 0) || (tcbPtrTbl[m->mutexOwner] != tcb))
 	{
-
-	    //so, take the new owner of mutex:
-		m->mutexOwner = uLipeKernelFindHighPrio(&m->tasksPending);
-
-		//change priority
-		mutexTCB = tcbPtrTbl[m->mutexOwner];
-		mutexTCB->taskPrio = OS_MUTEX_PRIO;
-
-		//Make mutex task ready:
-	    mutexTCB->taskStatus &= ~( 1 << kTaskPendMtx);
-	    if(mutexTCB->taskStatus == 0)
-	    {
-	        uLipePrioSet(OS_MUTEX_PRIO, &taskPrioList);
-	    }
-
-
 		OS_CRITICAL_OUT();
+		return(kMutexNotOwner);
+	}
 
-		//Check for a context switch
-		uLipeKernelTaskYield();
-
-
-		//all gone well:
+	//still held by a recursive take:
+	if(--m->mutexTaken != 0)
+	{
+		OS_CRITICAL_OUT();
 		return(kStatusOk);
 	}
 
+	uLipeMutexRelease(m, tcb);
+	uLipeMutexHandOff(m);
 
-	//If no tasks pending, so release mutex:
-	m->mutexTaken = FALSE;
-	m->mutexOwner = OS_MUTEX_PRIO;
+	//go back to the priority required by the mutexes still held:
+	uLipeKernelTaskPrioSet(tcb, uLipeMutexOwnerPrio(tcb));
 
     OS_CRITICAL_OUT();
 
@@ -198,6 +318,46 @@ OsStatus_t uLipeMutexGive(OsHandler_t h)
 	return(kStatusOk);
 }
 
+/*
+ * uLipeMutexTaskDelete()
+ */
+void uLipeMutexTaskDelete(struct OsTCB_ *tcb)
+{
+	MutexPtr_t wait = tcb->mtxWait;
+	MutexPtr_t m;
+	OsTCBPtr_t owner;
+	uint16_t prio;
+
+	//leaves the wait list first, so no owner priority is computed from it:
+	if(wait != NULL)
+	{
+		uLipePrioClr(tcb->taskPrio, &wait->tasksPending);
+		tcb->mtxBmp = NULL;
+		tcb->mtxWait = NULL;
+	}
+
+	//mutexes held are given to their waiters, even if taken recursively:
+	while(tcb->mtxHeld != NULL)
+	{
+		m = tcb->mtxHeld;
+		uLipeMutexRelease(m, tcb);
+		m->mutexTaken = 0;
+		uLipeMutexHandOff(m);
+	}
+
+	//the owners it was waiting for lose the priority it lent, along
+	//the chain until one keeps its priority:
+	while(wait != NULL)
+	{
+		owner = tcbPtrTbl[wait->mutexOwner];
+		prio = uLipeMutexOwnerPrio(owner);
+		if(owner->runPrio == prio) break;
+
+		uLipeKernelTaskPrioSet(owner, prio);
+		wait = owner->mtxWait;
+	}
+}
+
 /*
  * uLipeMutexDelete()
  */
@@ -215,7 +375,7 @@ OsStatus_t uLipeMutexDelete(OsHandler_t *h)
 	//Argument valid, then proceed:
 	OS_CRITICAL_IN();
 
-	if(m->mutexTaken != FALSE)
+	if(m->mutexTaken != 0)
 	{
 		//mutex taken, cant be deleted:
 		OS_CRITICAL_OUT();
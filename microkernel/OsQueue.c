@@ -23,16 +23,15 @@
 #define OS_Q_PEND_EMPTY 0x02 	//Pending to insert at least onde message in queue
 #define OS_Q_PEND_NOT   0x80	//Not pending any event
 
+#define OS_Q_ITEM_STRIDE(size)	(((size) + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1))
+
 #if OS_QUEUE_MODULE_EN > 0
 
 
 /*
  * External used variables
  */
-extern OsTCBPtr_t currentTask;
 extern OsTCBPtr_t tcbPtrTbl[];
-extern OsPrioList_t taskPrioList;
-extern OsDualPrioList_t timerPendingList;
 /*
  * Implementation:
  */
@@ -60,10 +59,11 @@ inline static void QueueRemoveLoop(OsHandler_t h)
 
 
 		//make this task ready:
-		tcbPtrTbl[i]->taskStatus &= ~((1 << kTaskPendQueue)|(1 << kTaskPendDelay));
+		uLipeKernelTimerStop(tcbPtrTbl[i]);
+		tcbPtrTbl[i]->taskStatus &= ~(1 << kTaskPendQueue);
 		if(tcbPtrTbl[i]->taskStatus == 0)
 		{
-	        uLipePrioSet(i, &taskPrioList);
+	        uLipeKernelTaskReady(tcbPtrTbl[i]);
 		}
 	}
 }
@@ -90,12 +90,21 @@ inline static void QueueInsertLoop(OsHandler_t h)
 
 
         //make this task ready:
-        tcbPtrTbl[i]->taskStatus &= ~((1 << kTaskPendQueue)|(1 << kTaskPendDelay));
+        uLipeKernelTimerStop(tcbPtrTbl[i]);
+        tcbPtrTbl[i]->taskStatus &= ~(1 << kTaskPendQueue);
         if(tcbPtrTbl[i]->taskStatus == 0)
         {
-            uLipePrioSet(i, &taskPrioList);
+            uLipeKernelTaskReady(tcbPtrTbl[i]);
         }
 	}	
+
+#if OS_SET_MODULE_EN > 0
+	//a task waiting on a set checks it again:
+	if(q->set != NULL)
+	{
+		uLipeSetSignal(q->set);
+	}
+#endif
 }
 
 /*
@@ -124,22 +133,45 @@ inline static void QueueDeleteLoop(OsHandler_t h)
 
 		//Set these tasks as ready:
         //make this task ready:
+        uLipeKernelTimerStop(tcbPtrTbl[i]);
         tcbPtrTbl[i]->taskStatus &= ~(1 << kTaskPendQueue);
         if(tcbPtrTbl[i]->taskStatus == 0)
         {
-            uLipePrioSet(i, &taskPrioList);
+            uLipeKernelTaskReady(tcbPtrTbl[i]);
         }
 
         //make this task ready:
+        uLipeKernelTimerStop(tcbPtrTbl[j]);
         tcbPtrTbl[j]->taskStatus &= ~(1 << kTaskPendQueue);
         if(tcbPtrTbl[j]->taskStatus == 0)
         {
-            uLipePrioSet(j, &taskPrioList);
+            uLipeKernelTaskReady(tcbPtrTbl[j]);
         }
 		
 	}		
 }
 
+#if OS_DEFERRED_POST_EN > 0
+/*
+ * QueueInsertDeferred()
+ *
+ * Internal function, executes a insert recorded by uLipeQueueInsertFromISR()
+ */
+static void QueueInsertDeferred(OsHandler_t h, uintptr_t arg)
+{
+	uint32_t sReg = 0;
+	QueuePtr_t q = (QueuePtr_t)h;
+
+	if(uLipeQueueInsert(h, (void *)arg, OS_Q_NON_BLOCK, 0) != kStatusOk)
+	{
+		//the isr was already told the post is done, keep track of it:
+		OS_CRITICAL_IN();
+		q->deferDrops++;
+		OS_CRITICAL_OUT();
+	}
+}
+#endif
+
 /*
  * uLipeQueueCreate()
  */
@@ -180,6 +212,15 @@ OsHandler_t uLipeQueueCreate(uint32_t slots, OsStatus_t *err)
 	q->queueBack = 0;
 	q->queueFront = 0;
 	q->usedSlots = 0;
+	q->itemSize = 0;
+	memset(&q->queueInsertWait, 0, sizeof(OsPrioList_t));
+	memset(&q->queueSlotWait, 0, sizeof(OsPrioList_t));
+#if OS_SET_MODULE_EN > 0
+	q->set = NULL;
+#endif
+#if OS_DEFERRED_POST_EN > 0
+	q->deferDrops = 0;
+#endif
 
     OS_CRITICAL_OUT();
 
@@ -190,9 +231,291 @@ OsHandler_t uLipeQueueCreate(uint32_t slots, OsStatus_t *err)
 }
 
 /*
- * uLipeQueueInsert()
+ * uLipeQueueCreateCopy()
+ */
+OsHandler_t uLipeQueueCreateCopy(uint32_t itemSize, uint32_t slots, OsStatus_t *err)
+{
+	QueuePtr_t q;
+	uint32_t size;
+
+	//check arguments before taking memory:
+	if((itemSize == 0) || (itemSize > 0xFFFF) || (slots == 0) || (slots > 0xFFFF))
+	{
+		if(err != NULL) *err = kInvalidParam;
+		return((OsHandler_t)NULL);
+	}
+
+	//items are placed just after the control block, each one on a
+	//word boundary:
+	size = OS_Q_ITEM_STRIDE(itemSize) * slots;
+	if(size > (OS_MAX_SIZED_HEAP_BLOCK - sizeof(Queue_t)))
+	{
+		if(err != NULL) *err = kOutOfQueue;
+		return((OsHandler_t)NULL);
+	}
+
+	q = uLipeMemAlloc(sizeof(Queue_t) + size);
+	if(q == NULL)
+	{
+		if(err != NULL) *err = kOutOfQueue;
+		return((OsHandler_t)NULL);
+	}
+
+	//fill the control block:
+	q->queueBase = NULL;
+	q->numSlots  = slots;
+	q->queueBack = 0;
+	q->queueFront = 0;
+	q->usedSlots = 0;
+	q->itemSize = itemSize;
+	memset(&q->queueInsertWait, 0, sizeof(OsPrioList_t));
+	memset(&q->queueSlotWait, 0, sizeof(OsPrioList_t));
+#if OS_SET_MODULE_EN > 0
+	q->set = NULL;
+#endif
+#if OS_DEFERRED_POST_EN > 0
+	q->deferDrops = 0;
+#endif
+
+	if(err != NULL) *err = kStatusOk;
+
+	//Return in handler form:
+	return((OsHandler_t)q);
+}
+
+/*
+ * uLipeQueueCopy()
+ *
+ * Internal function, copies an item, word aligned items of word multiple
+ * sizes are moved a word at a time.
+ */
+static void uLipeQueueCopy(void *dst, const void *src, uint32_t size)
+{
+	uint32_t *wDst = (uint32_t *)dst;
+	const uint32_t *wSrc = (const uint32_t *)src;
+	uint8_t *bDst = (uint8_t *)dst;
+	const uint8_t *bSrc = (const uint8_t *)src;
+
+	if((((uintptr_t)dst | (uintptr_t)src | size) & (sizeof(uint32_t) - 1)) == 0)
+	{
+		for(size /= sizeof(uint32_t); size != 0; size--)
+		{
+			*wDst++ = *wSrc++;
+		}
+	}
+	else
+	{
+		for(; size != 0; size--)
+		{
+			*bDst++ = *bSrc++;
+		}
+	}
+}
+
+/*
+ * uLipeQueueWait()
+ *
+ * Internal function, blocks current task on a wait list of a queue
+ * up to an absolute tick, returns false without blocking if that tick
+ * was already reached, must be called with interrupts disabled.
  */
-OsStatus_t uLipeQueueInsert(OsHandler_t h, void *data, uint8_t opt, uint16_t timeout)
+static bool uLipeQueueWait(OsPrioListPtr_t waitList, bool forever, uint32_t deadline)
+{
+	uint32_t ticks = deadline - uLipeKernelTickGet();
+
+	if((forever == false) && ((ticks == 0) || (ticks > OS_DEADLINE_WINDOW)))
+	{
+		return(false);
+	}
+
+	uLipeKernelTaskUnready(currentTask);
+	currentTask->taskStatus |= (1 << kTaskPendQueue);
+	currentTask->queueBmp = waitList;
+	uLipePrioSet(currentTask->taskPrio, waitList);
+
+	if(forever == false)
+	{
+		uLipeKernelTimerStart(currentTask, ticks);
+	}
+
+	return(true);
+}
+
+/*
+ * uLipeQueueSendItem()
+ *
+ * Internal function, copies an item to a queue waiting up to a relative
+ * timeout or up to an absolute deadline tick.
+ */
+static OsStatus_t uLipeQueueSendItem(OsHandler_t h, const void *item, uint8_t opt, uint32_t timeout, bool deadline)
+{
+	QueuePtr_t q = (QueuePtr_t)h;
+	uint32_t sReg = 0;
+	bool forever = ((deadline == false) && (timeout == 0)) ? true : false;
+
+	//check arguments:
+	if((q == 0) || (item == NULL) || (q->itemSize == 0))
+	{
+		return(kInvalidParam);
+	}
+
+	OS_TRACE(kTraceQueueInsert, h);
+
+	OS_CRITICAL_IN();
+
+	//relative timeouts are taken as a deadline, so a task woken and
+	//passed by other one waits only what is left:
+	if(deadline == false) timeout += uLipeKernelTickGet();
+
+	while(q->usedSlots >= q->numSlots)
+	{
+		if(opt != OS_Q_BLOCK_FULL)
+		{
+			OS_CRITICAL_OUT();
+			return(kQueueFull);
+		}
+
+		if(uLipeQueueWait(&q->queueSlotWait, forever, timeout) == false)
+		{
+			OS_CRITICAL_OUT();
+			return(kTimeout);
+		}
+
+		OS_CRITICAL_OUT();
+
+		//So check for a context switch:
+		uLipeKernelTaskYield();
+
+		OS_CRITICAL_IN();
+	}
+
+	//freespace, copy the item to the tail:
+	uLipeQueueCopy((uint8_t *)(q + 1) + (q->queueFront * OS_Q_ITEM_STRIDE(q->itemSize)),
+				   item, q->itemSize);
+	q->queueFront++;
+	if(q->queueFront > (q->numSlots - 1))
+	{
+		q->queueFront = 0;
+	}
+	q->usedSlots++;
+
+	//Run insertion update loop:
+	QueueInsertLoop(h);
+
+	OS_CRITICAL_OUT();
+
+	//check for a context switch:
+	uLipeKernelTaskYield();
+
+	return(kStatusOk);
+}
+
+/*
+ * uLipeQueueSend()
+ */
+OsStatus_t uLipeQueueSend(OsHandler_t h, const void *item, uint8_t opt, uint32_t timeout)
+{
+	return(uLipeQueueSendItem(h, item, opt, timeout, false));
+}
+
+/*
+ * uLipeQueueSendUntil()
+ */
+OsStatus_t uLipeQueueSendUntil(OsHandler_t h, const void *item, uint8_t opt, uint32_t deadline)
+{
+	return(uLipeQueueSendItem(h, item, opt, deadline, true));
+}
+
+/*
+ * uLipeQueueReceiveItem()
+ *
+ * Internal function, copies and removes an item from a queue waiting up
+ * to a relative timeout or up to an absolute deadline tick.
+ */
+static OsStatus_t uLipeQueueReceiveItem(OsHandler_t h, void *item, uint8_t opt, uint32_t timeout, bool deadline)
+{
+	QueuePtr_t q = (QueuePtr_t)h;
+	uint32_t sReg = 0;
+	bool forever = ((deadline == false) && (timeout == 0)) ? true : false;
+
+	//check arguments:
+	if((q == 0) || (item == NULL) || (q->itemSize == 0))
+	{
+		return(kInvalidParam);
+	}
+
+	OS_TRACE(kTraceQueueRemove, h);
+
+	OS_CRITICAL_IN();
+
+	if(deadline == false) timeout += uLipeKernelTickGet();
+
+	while(q->usedSlots == 0)
+	{
+		if(opt != OS_Q_BLOCK_EMPTY)
+		{
+			OS_CRITICAL_OUT();
+			return(kQueueEmpty);
+		}
+
+		if(uLipeQueueWait(&q->queueInsertWait, forever, timeout) == false)
+		{
+			OS_CRITICAL_OUT();
+			return(kTimeout);
+		}
+
+		OS_CRITICAL_OUT();
+
+		//So check for a context switch:
+		uLipeKernelTaskYield();
+
+		OS_CRITICAL_IN();
+	}
+
+	//queue holds data, copy the head out:
+	uLipeQueueCopy(item, (uint8_t *)(q + 1) + (q->queueBack * OS_Q_ITEM_STRIDE(q->itemSize)),
+				   q->itemSize);
+	q->queueBack++;
+	if(q->queueBack > (q->numSlots - 1))
+	{
+		q->queueBack = 0;
+	}
+	q->usedSlots--;
+
+	//Update tasks wich pend this queue:
+	QueueRemoveLoop(h);
+
+	OS_CRITICAL_OUT();
+
+	//Check for context switching:
+	uLipeKernelTaskYield();
+
+	return(kStatusOk);
+}
+
+/*
+ * uLipeQueueReceive()
+ */
+OsStatus_t uLipeQueueReceive(OsHandler_t h, void *item, uint8_t opt, uint32_t timeout)
+{
+	return(uLipeQueueReceiveItem(h, item, opt, timeout, false));
+}
+
+/*
+ * uLipeQueueReceiveUntil()
+ */
+OsStatus_t uLipeQueueReceiveUntil(OsHandler_t h, void *item, uint8_t opt, uint32_t deadline)
+{
+	return(uLipeQueueReceiveItem(h, item, opt, deadline, true));
+}
+
+/*
+ * uLipeQueuePost()
+ *
+ * Internal function, inserts on a queue waiting up to a relative timeout
+ * or up to an absolute deadline tick.
+ */
+static OsStatus_t uLipeQueuePost(OsHandler_t h, void *data, uint8_t opt, uint32_t timeout, bool deadline)
 {
     QueuePtr_t q = (QueuePtr_t)h;
 	uint32_t sReg = 0;
@@ -202,39 +525,44 @@ OsStatus_t uLipeQueueInsert(OsHandler_t h, void *data, uint8_t opt, uint16_t tim
 	{
 		return(kInvalidParam);
 	}
-	if(q == 0)
+	if((q == 0) || (q->itemSize != 0))
 	{
 		return(kInvalidParam);
 	}
 
 
+	OS_TRACE(kTraceQueueInsert, h);
+
 	//Arguments valid, proceed then:
 	OS_CRITICAL_IN();
 
 	//Before insert, check queue status:
 	if(q->usedSlots >= q->numSlots)
 	{
-		OS_CRITICAL_OUT();
-
-		//Queue full, check options:
+		//Queue full, check options, the section is kept so a remove
+		//cannot happen before this task is on the wait list:
 		switch(opt)
 		{
 			case OS_Q_BLOCK_FULL:
 			{
 				//suspend current task:
-				uLipePrioClr(currentTask->taskPrio, &taskPrioList);
+				uLipeKernelTaskUnready(currentTask);
 				currentTask->taskStatus |= (1 << kTaskPendQueue);
-				if(timeout != 0)
-				{
-				    currentTask->taskStatus |= (1 << kTaskPendDelay);
-	                currentTask->delayTime = timeout;
-	                uLipePrioSet(currentTask->taskPrio, &timerPendingList.list[timerPendingList.activeList]);
-				}
 				currentTask->queueBmp = &q->queueSlotWait;
 
 				//Adds task to wait list:
 				uLipePrioSet(currentTask->taskPrio, &q->queueSlotWait);
 
+				//timeout goes last, an expired deadline wakes it at once:
+				if(deadline != false)
+				{
+					uLipeKernelTimerStartAt(currentTask, timeout);
+				}
+				else if(timeout != 0)
+				{
+	                uLipeKernelTimerStart(currentTask, timeout);
+				}
+
 				OS_CRITICAL_OUT();
 
 				//So check for a context switch:
@@ -246,13 +574,8 @@ OsStatus_t uLipeQueueInsert(OsHandler_t h, void *data, uint8_t opt, uint16_t tim
 
 			case OS_Q_NON_BLOCK:
 			{
-			    if(q->usedSlots < q->numSlots) break;
-			    else
-			    {
-	                OS_CRITICAL_OUT();
-	                return(kQueueFull);
-			    }
-
+                OS_CRITICAL_OUT();
+                return(kQueueFull);
 			}
 			break;
 
@@ -293,50 +616,72 @@ OsStatus_t uLipeQueueInsert(OsHandler_t h, void *data, uint8_t opt, uint16_t tim
 	return(kStatusOk);
 }
 /*
- * uLipeQueueRemove()
+ * uLipeQueueInsert()
+ */
+OsStatus_t uLipeQueueInsert(OsHandler_t h, void *data, uint8_t opt, uint32_t timeout)
+{
+	return(uLipeQueuePost(h, data, opt, timeout, false));
+}
+
+/*
+ * uLipeQueueInsertUntil()
  */
-void *uLipeQueueRemove(OsHandler_t h, uint8_t opt, uint16_t timeout, OsStatus_t *err)
+OsStatus_t uLipeQueueInsertUntil(OsHandler_t h, void *data, uint8_t opt, uint32_t deadline)
+{
+	return(uLipeQueuePost(h, data, opt, deadline, true));
+}
+
+/*
+ * uLipeQueuePend()
+ *
+ * Internal function, removes from a queue waiting up to a relative timeout
+ * or up to an absolute deadline tick.
+ */
+static void *uLipeQueuePend(OsHandler_t h, uint8_t opt, uint32_t timeout, bool deadline, OsStatus_t *err)
 {
     QueuePtr_t q = (QueuePtr_t)h;
 	uint32_t sReg = 0;
 	void *ptr = NULL;
 
 	//check arguments:
-	if(q == 0)
+	if((q == 0) || (q->itemSize != 0))
 	{
         if(err != NULL )*err = kInvalidParam ;
 		return(NULL);
 	}
 
+	OS_TRACE(kTraceQueueRemove, h);
+
 	//Arguments valid, then proceed:
 	OS_CRITICAL_IN();
 
 	//Check queue status first:
 	if(q->usedSlots == 0)
 	{
-		OS_CRITICAL_OUT();
-
-		//Queue full, check options:
+		//Queue empty, check options, the section is kept so an insert
+		//cannot happen before this task is on the wait list:
 		switch(opt)
 		{
 			case OS_Q_BLOCK_EMPTY:
 			{
 				//task will block so:
-				OS_CRITICAL_IN();
-
-                uLipePrioClr(currentTask->taskPrio, &taskPrioList);
+                uLipeKernelTaskUnready(currentTask);
 				//prepare task to wait
                 currentTask->taskStatus |= (1 << kTaskPendQueue);
-                if(timeout != 0)
-                {
-                    currentTask->taskStatus |= (1 << kTaskPendDelay);
-                    currentTask->delayTime = timeout;
-                    uLipePrioSet(currentTask->taskPrio, &timerPendingList.list[timerPendingList.activeList]);
-                }
 
 				//Adds task to wait list:
                 currentTask->queueBmp = &q->queueInsertWait;
 				uLipePrioSet(currentTask->taskPrio, &q->queueInsertWait);
+
+				//timeout goes last, an expired deadline wakes it at once:
+                if(deadline != false)
+                {
+                    uLipeKernelTimerStartAt(currentTask, timeout);
+                }
+                else if(timeout != 0)
+                {
+                    uLipeKernelTimerStart(currentTask, timeout);
+                }
 				OS_CRITICAL_OUT();
 
 				//So check for a context switch:
@@ -349,20 +694,16 @@ void *uLipeQueueRemove(OsHandler_t h, uint8_t opt, uint16_t timeout, OsStatus_t
 			break;
             case OS_Q_NON_BLOCK:
             {
-                if(q->usedSlots != 0) break;
-                else
-                {
-                    OS_CRITICAL_OUT();
-
-                    if(err != NULL )*err = kQueueEmpty;
-                    return(ptr);
-                }
+                OS_CRITICAL_OUT();
 
+                if(err != NULL )*err = kQueueEmpty;
+                return(ptr);
             }
             break;
 			default:
 			{
 				//All other cases, only return:
+				OS_CRITICAL_OUT();
                 if(err != NULL )*err = kQueueEmpty;
 				return(ptr);
 			}
@@ -396,6 +737,180 @@ void *uLipeQueueRemove(OsHandler_t h, uint8_t opt, uint16_t timeout, OsStatus_t
 	//All gone well:
 	return(ptr);
 }
+/*
+ * uLipeQueueRemove()
+ */
+void *uLipeQueueRemove(OsHandler_t h, uint8_t opt, uint32_t timeout, OsStatus_t *err)
+{
+	return(uLipeQueuePend(h, opt, timeout, false, err));
+}
+
+/*
+ * uLipeQueueRemoveUntil()
+ */
+void *uLipeQueueRemoveUntil(OsHandler_t h, uint8_t opt, uint32_t deadline, OsStatus_t *err)
+{
+	return(uLipeQueuePend(h, opt, deadline, true, err));
+}
+
+/*
+ * uLipeQueueInsertN()
+ */
+uint32_t uLipeQueueInsertN(OsHandler_t h, void **data, uint32_t n, uint8_t opt, uint32_t timeout, OsStatus_t *err)
+{
+	QueuePtr_t q = (QueuePtr_t)h;
+	uint32_t sReg = 0;
+	uint32_t i;
+	bool forever = (timeout == 0) ? true : false;
+
+	//check arguments, a null item would look like an empty queue:
+	if((q == 0) || (q->itemSize != 0) || (data == NULL) || (n == 0))
+	{
+		if(err != NULL) *err = kInvalidParam;
+		return(0);
+	}
+	for(i = 0; i < n; i++)
+	{
+		if(data[i] == NULL)
+		{
+			if(err != NULL) *err = kInvalidParam;
+			return(0);
+		}
+	}
+
+	OS_TRACE(kTraceQueueInsert, h);
+
+	OS_CRITICAL_IN();
+
+	timeout += uLipeKernelTickGet();
+
+	//waits only while no item fits:
+	while(q->usedSlots >= q->numSlots)
+	{
+		if(opt != OS_Q_BLOCK_FULL)
+		{
+			OS_CRITICAL_OUT();
+			if(err != NULL) *err = kQueueFull;
+			return(0);
+		}
+
+		if(uLipeQueueWait(&q->queueSlotWait, forever, timeout) == false)
+		{
+			OS_CRITICAL_OUT();
+			if(err != NULL) *err = kTimeout;
+			return(0);
+		}
+
+		OS_CRITICAL_OUT();
+		uLipeKernelTaskYield();
+		OS_CRITICAL_IN();
+	}
+
+	for(i = 0; (i < n) && (q->usedSlots < q->numSlots); i++)
+	{
+		q->queueBase[q->queueFront] = data[i];
+		q->queueFront++;
+		if(q->queueFront > (q->numSlots - 1))
+		{
+			q->queueFront = 0;
+		}
+		q->usedSlots++;
+	}
+
+	//a single wake pass, one waiting remover for each item:
+	for(n = i; (n != 0) && (q->queueInsertWait.prioGrp != 0); n--)
+	{
+		QueueInsertLoop(h);
+	}
+
+#if OS_SET_MODULE_EN > 0
+	//the loop above stops with no waiting remover, the set is told apart:
+	if((i != 0) && (q->set != NULL))
+	{
+		uLipeSetSignal(q->set);
+	}
+#endif
+
+	OS_CRITICAL_OUT();
+
+	//and a single reschedule for the whole batch:
+	uLipeKernelTaskYield();
+
+	if(err != NULL) *err = kStatusOk;
+	return(i);
+}
+
+/*
+ * uLipeQueueRemoveN()
+ */
+uint32_t uLipeQueueRemoveN(OsHandler_t h, void **data, uint32_t n, uint8_t opt, uint32_t timeout, OsStatus_t *err)
+{
+	QueuePtr_t q = (QueuePtr_t)h;
+	uint32_t sReg = 0;
+	uint32_t i;
+	bool forever = (timeout == 0) ? true : false;
+
+	//check arguments:
+	if((q == 0) || (q->itemSize != 0) || (data == NULL) || (n == 0))
+	{
+		if(err != NULL) *err = kInvalidParam;
+		return(0);
+	}
+
+	OS_TRACE(kTraceQueueRemove, h);
+
+	OS_CRITICAL_IN();
+
+	timeout += uLipeKernelTickGet();
+
+	//waits only while the queue is empty:
+	while(q->usedSlots == 0)
+	{
+		if(opt != OS_Q_BLOCK_EMPTY)
+		{
+			OS_CRITICAL_OUT();
+			if(err != NULL) *err = kQueueEmpty;
+			return(0);
+		}
+
+		if(uLipeQueueWait(&q->queueInsertWait, forever, timeout) == false)
+		{
+			OS_CRITICAL_OUT();
+			if(err != NULL) *err = kTimeout;
+			return(0);
+		}
+
+		OS_CRITICAL_OUT();
+		uLipeKernelTaskYield();
+		OS_CRITICAL_IN();
+	}
+
+	for(i = 0; (i < n) && (q->usedSlots != 0); i++)
+	{
+		data[i] = (void *)q->queueBase[q->queueBack];
+		q->queueBack++;
+		if(q->queueBack > (q->numSlots - 1))
+		{
+			q->queueBack = 0;
+		}
+		q->usedSlots--;
+	}
+
+	//a single wake pass, one waiting inserter for each freed slot:
+	for(n = i; (n != 0) && (q->queueSlotWait.prioGrp != 0); n--)
+	{
+		QueueRemoveLoop(h);
+	}
+
+	OS_CRITICAL_OUT();
+
+	//and a single reschedule for the whole batch:
+	uLipeKernelTaskYield();
+
+	if(err != NULL) *err = kStatusOk;
+	return(i);
+}
+
 /*
  * uLipeQueueFlush()
  */
@@ -436,28 +951,40 @@ OsStatus_t uLipeQueueFlush(OsHandler_t h)
 OsStatus_t uLipeQueueDelete(OsHandler_t *h)
 {
 	uint32_t sReg;
-	QueuePtr_t q = (QueuePtr_t)h;
+	QueuePtr_t q;
 
 
 	//check arguments:
-	if( h == (OsHandler_t *)NULL)
+	if((h == (OsHandler_t *)NULL) || (*h == 0))
 	{
 		return(kInvalidParam);
 	}
 
+	q = (QueuePtr_t)*h;
 
 	//Argument valid, then proceed:
 
 	OS_CRITICAL_IN();
 
-	//Assert all tasks pending the queue will be destroyed:
+#if OS_SET_MODULE_EN > 0
+	//unlink it from its set:
+	if(q->set != NULL)
+	{
+		uLipeSetDetach(q->set, *h);
+	}
+#endif
+
+	//Assert all tasks pending the queue will be destroyed, copy
+	//queues have its items on the same block:
 	QueueDeleteLoop(*h);
-	uLipeMemFree(q->queueBase);
+	if(q->itemSize == 0)
+	{
+		uLipeMemFree(q->queueBase);
+	}
 	uLipeMemFree(q);
 
 	//Destroy the reference:
-	 h = (OsHandler_t *)NULL;
-	 q = NULL;
+	*h = 0;
 
 	OS_CRITICAL_OUT();
 
@@ -467,4 +994,40 @@ OsStatus_t uLipeQueueDelete(OsHandler_t *h)
 	return(kStatusOk);
 }
 
+#if OS_DEFERRED_POST_EN > 0
+/*
+ * uLipeQueueInsertFromISR()
+ */
+OsStatus_t uLipeQueueInsertFromISR(OsHandler_t h, void *data)
+{
+	//check arguments:
+	if(h == NULL)
+	{
+		return(kInvalidParam);
+	}
+
+	//The insertion is done when the outermost isr exits:
+	return(uLipeKernelDeferPost(&QueueInsertDeferred, h, (uintptr_t)data));
+}
+
+/*
+ * uLipeQueueDeferDrops()
+ */
+OsStatus_t uLipeQueueDeferDrops(OsHandler_t h, uint32_t *drops)
+{
+	QueuePtr_t q = (QueuePtr_t)h;
+
+	//check arguments:
+	if((h == NULL) || (drops == NULL))
+	{
+		return(kInvalidParam);
+	}
+
+	//a single word, no need of critical section:
+	*drops = q->deferDrops;
+
+	return(kStatusOk);
+}
+#endif
+
 #endif
@@ -0,0 +1,390 @@
+/*!
+ *
+ * 							ULIPE RTOS VERSION 4
+ *
+ *
+ *  \file OsRing.c
+ *
+ *  \brief this file contains the routines for single producer single
+ *  consumer ring buffers
+ *
+ *	In this file the user will find the implementation of the ring
+ *	buffers, the indexes run free and each side only writes its own one,
+ *	so reads and writes need no critical section, a memory barrier orders
+ *	the bytes before the index which publishes them.
+ *
+ *  Author: FSN
+ *
+ */
+
+#include "uLipeRtos4.h"
+
+#if OS_RING_MODULE_EN > 0
+
+/*
+ * Ring internal macros:
+ */
+#define OS_RING_BUFFER(r)	((uint8_t *)((r) + 1))
+
+/*
+ * Module implementation:
+ */
+
+/*
+ * uLipeRingWake()
+ *
+ * Internal function, called by writer when a reader is blocked, wakes it
+ * up if the watermark was reached.
+ */
+static void uLipeRingWake(RingPtr_t r)
+{
+	uint32_t sReg = 0;
+	OsTCBPtr_t tcb;
+
+	OS_CRITICAL_IN();
+
+	tcb = r->reader;
+	if((tcb != NULL) && (tcb->taskStatus & (1 << kTaskPendRing)) &&
+	   ((r->head - r->tail) >= r->watermark))
+	{
+		//the reader clears its link when it runs, so the ring is not
+		//deleted before:
+		uLipeKernelTimerStop(tcb);
+		tcb->taskStatus &= ~(1 << kTaskPendRing);
+		if(tcb->taskStatus == 0)
+		{
+			uLipeKernelTaskReady(tcb);
+		}
+	}
+
+	OS_CRITICAL_OUT();
+
+	//check for a context switch, in a isr it is done on its exit:
+	uLipeKernelTaskYield();
+}
+
+/*
+ * uLipeRingPublish()
+ *
+ * Internal function, moves the write index over bytes already written.
+ */
+static void uLipeRingPublish(RingPtr_t r, uint32_t head)
+{
+	//bytes are visible before the index:
+	OS_PORT_MEM_BARRIER();
+	r->head = head;
+
+	//and the index before the reader is checked, the reader does the
+	//opposite when it blocks:
+	OS_PORT_MEM_BARRIER();
+	if(r->reader != NULL)
+	{
+		uLipeRingWake(r);
+	}
+}
+
+/*
+ * uLipeRingCreate()
+ */
+OsHandler_t uLipeRingCreate(uint32_t size, uint32_t watermark, OsStatus_t *err)
+{
+	RingPtr_t r;
+
+	//check arguments before taking memory:
+	if((size == 0) || ((size & (size - 1)) != 0) || (watermark == 0) || (watermark > size))
+	{
+		if(err != NULL) *err = kInvalidParam;
+		return((OsHandler_t)NULL);
+	}
+
+	if(size > (OS_MAX_SIZED_HEAP_BLOCK - sizeof(Ring_t)))
+	{
+		if(err != NULL) *err = kOutOfMem;
+		return((OsHandler_t)NULL);
+	}
+
+	r = uLipeMemAlloc(sizeof(Ring_t) + size);
+	if(r == NULL)
+	{
+		if(err != NULL) *err = kOutOfMem;
+		return((OsHandler_t)NULL);
+	}
+
+	r->head = 0;
+	r->tail = 0;
+	r->mask = size - 1;
+	r->watermark = watermark;
+	r->reader = NULL;
+
+	if(err != NULL) *err = kStatusOk;
+	return((OsHandler_t)r);
+}
+
+/*
+ * uLipeRingWrite()
+ */
+uint32_t uLipeRingWrite(OsHandler_t h, const void *data, uint32_t len)
+{
+	RingPtr_t r = (RingPtr_t)h;
+	uint32_t head;
+	uint32_t offset;
+	uint32_t first;
+
+	//check arguments:
+	if((h == 0) || (data == NULL)) return(0);
+
+	head = r->head;
+
+	//the reader only frees space, so it is at least this:
+	if(len > ((r->mask + 1) - (head - r->tail)))
+	{
+		len = (r->mask + 1) - (head - r->tail);
+	}
+	if(len == 0) return(0);
+
+	//two spans when the bytes wrap around the storage end:
+	offset = head & r->mask;
+	first = (r->mask + 1) - offset;
+	if(first > len) first = len;
+
+	memcpy(OS_RING_BUFFER(r) + offset, data, first);
+	memcpy(OS_RING_BUFFER(r), (const uint8_t *)data + first, len - first);
+
+	uLipeRingPublish(r, head + len);
+
+	return(len);
+}
+
+/*
+ * uLipeRingWriteSpan()
+ */
+uint32_t uLipeRingWriteSpan(OsHandler_t h, void **span)
+{
+	RingPtr_t r = (RingPtr_t)h;
+	uint32_t head;
+	uint32_t offset;
+	uint32_t ret;
+
+	//check arguments:
+	if((h == 0) || (span == NULL)) return(0);
+
+	head = r->head;
+	offset = head & r->mask;
+
+	//free space up to the reader or up to the storage end:
+	ret = (r->mask + 1) - (head - r->tail);
+	if(ret > ((r->mask + 1) - offset)) ret = (r->mask + 1) - offset;
+
+	*span = OS_RING_BUFFER(r) + offset;
+	return(ret);
+}
+
+/*
+ * uLipeRingWriteCommit()
+ */
+OsStatus_t uLipeRingWriteCommit(OsHandler_t h, uint32_t len)
+{
+	RingPtr_t r = (RingPtr_t)h;
+	uint32_t head;
+
+	//check arguments:
+	if(h == 0) return(kInvalidParam);
+
+	head = r->head;
+	if((len > ((r->mask + 1) - (head - r->tail))) ||
+	   (len > ((r->mask + 1) - (head & r->mask))))
+	{
+		return(kInvalidParam);
+	}
+
+	if(len != 0)
+	{
+		uLipeRingPublish(r, head + len);
+	}
+
+	return(kStatusOk);
+}
+
+/*
+ * uLipeRingRead()
+ */
+uint32_t uLipeRingRead(OsHandler_t h, void *data, uint32_t len)
+{
+	RingPtr_t r = (RingPtr_t)h;
+	uint32_t tail;
+	uint32_t offset;
+	uint32_t first;
+
+	//check arguments:
+	if((h == 0) || (data == NULL)) return(0);
+
+	tail = r->tail;
+
+	//the writer only adds bytes, so there are at least these:
+	if(len > (r->head - tail)) len = r->head - tail;
+	if(len == 0) return(0);
+
+	//bytes are read only after the index which published them:
+	OS_PORT_MEM_BARRIER();
+
+	offset = tail & r->mask;
+	first = (r->mask + 1) - offset;
+	if(first > len) first = len;
+
+	memcpy(data, OS_RING_BUFFER(r) + offset, first);
+	memcpy((uint8_t *)data + first, OS_RING_BUFFER(r), len - first);
+
+	//the space is given back only after its bytes were copied:
+	OS_PORT_MEM_BARRIER();
+	r->tail = tail + len;
+
+	return(len);
+}
+
+/*
+ * uLipeRingReadSpan()
+ */
+uint32_t uLipeRingReadSpan(OsHandler_t h, void **span)
+{
+	RingPtr_t r = (RingPtr_t)h;
+	uint32_t tail;
+	uint32_t offset;
+	uint32_t ret;
+
+	//check arguments:
+	if((h == 0) || (span == NULL)) return(0);
+
+	tail = r->tail;
+	offset = tail & r->mask;
+
+	//stored bytes up to the writer or up to the storage end:
+	ret = r->head - tail;
+	if(ret > ((r->mask + 1) - offset)) ret = (r->mask + 1) - offset;
+
+	OS_PORT_MEM_BARRIER();
+
+	*span = OS_RING_BUFFER(r) + offset;
+	return(ret);
+}
+
+/*
+ * uLipeRingReadRelease()
+ */
+OsStatus_t uLipeRingReadRelease(OsHandler_t h, uint32_t len)
+{
+	RingPtr_t r = (RingPtr_t)h;
+	uint32_t tail;
+
+	//check arguments:
+	if(h == 0) return(kInvalidParam);
+
+	tail = r->tail;
+	if((len > (r->head - tail)) || (len > ((r->mask + 1) - (tail & r->mask))))
+	{
+		return(kInvalidParam);
+	}
+
+	OS_PORT_MEM_BARRIER();
+	r->tail = tail + len;
+
+	return(kStatusOk);
+}
+
+/*
+ * uLipeRingCount()
+ */
+uint32_t uLipeRingCount(OsHandler_t h)
+{
+	RingPtr_t r = (RingPtr_t)h;
+
+	//check arguments:
+	if(h == 0) return(0);
+
+	return(r->head - r->tail);
+}
+
+/*
+ * uLipeRingWait()
+ */
+OsStatus_t uLipeRingWait(OsHandler_t h, uint32_t timeout)
+{
+	uint32_t sReg = 0;
+	RingPtr_t r = (RingPtr_t)h;
+	OsStatus_t ret = kStatusOk;
+
+	//check arguments:
+	if(h == 0) return(kInvalidParam);
+
+	//fast path, no kernel call while the writer is ahead:
+	if((r->head - r->tail) >= r->watermark) return(kStatusOk);
+
+	OS_CRITICAL_IN();
+
+	//the reader is visible before the index is checked again, so a
+	//writer either sees it or its bytes are seen here:
+	r->reader = currentTask;
+	OS_PORT_MEM_BARRIER();
+
+	if((r->head - r->tail) < r->watermark)
+	{
+		uLipeKernelTaskUnready(currentTask);
+		currentTask->taskStatus |= (1 << kTaskPendRing);
+		if(timeout != 0)
+		{
+			uLipeKernelTimerStart(currentTask, timeout);
+		}
+
+		OS_CRITICAL_OUT();
+
+		//Task suspended, find a new task to run:
+		uLipeKernelTaskYield();
+
+		OS_CRITICAL_IN();
+
+		//woken by timeout:
+		if((r->head - r->tail) < r->watermark)
+		{
+			ret = kTimeout;
+		}
+	}
+
+	r->reader = NULL;
+
+	OS_CRITICAL_OUT();
+
+	return(ret);
+}
+
+/*
+ * uLipeRingDelete()
+ */
+OsStatus_t uLipeRingDelete(OsHandler_t *h)
+{
+	uint32_t sReg = 0;
+
+	//check arguments:
+	if((h == NULL) || (*h == 0))
+	{
+		return(kInvalidParam);
+	}
+
+	OS_CRITICAL_IN();
+
+	//the reader waiting would resume on a freed ring:
+	if(((RingPtr_t)*h)->reader != NULL)
+	{
+		OS_CRITICAL_OUT();
+		return(kInvalidParam);
+	}
+
+	uLipeMemFree(*h);
+
+	OS_CRITICAL_OUT();
+
+	//Destroy reference for this control block:
+	*h = 0;
+
+	return(kStatusOk);
+}
+
+#endif
@@ -28,10 +28,7 @@
  * External modules variables:
  */
 
-extern OsTCBPtr_t currentTask;
 extern OsTCBPtr_t tcbPtrTbl[];
-extern OsPrioList_t taskPrioList;
-extern OsDualPrioList_t timerPendingList;
 
 /*
  * Module implementation:
@@ -55,13 +52,21 @@ inline static void SemPostLoop(OsHandler_t h)
 		uLipePrioClr(i, &s->tasksWaiting);
 
         //make this task ready:
-        tcbPtrTbl[i]->taskStatus &= ~((1 << kTaskPendSem)|(1 << kTaskPendDelay));
+        uLipeKernelTimerStop(tcbPtrTbl[i]);
+        tcbPtrTbl[i]->taskStatus &= ~(1 << kTaskPendSem);
         if(tcbPtrTbl[i]->taskStatus == 0)
         {
-            uLipePrioSet(i, &taskPrioList);
+            uLipeKernelTaskReady(tcbPtrTbl[i]);
         }
 	}
 
+#if OS_SET_MODULE_EN > 0
+	//a task waiting on a set checks it again:
+	if(s->set != NULL)
+	{
+		uLipeSetSignal(s->set);
+	}
+#endif
 }
 
 /*
@@ -83,16 +88,29 @@ inline static void SemDeleteLoop(OsHandler_t h)
 		{
 			uLipePrioClr(i, &s->tasksWaiting);
 			//Make this task ready, and add it to ready list:
-	        tcbPtrTbl[i]->taskStatus &= ~((1 << kTaskPendSem)|(1 << kTaskPendDelay));
+	        uLipeKernelTimerStop(tcbPtrTbl[i]);
+	        tcbPtrTbl[i]->taskStatus &= ~(1 << kTaskPendSem);
 	        if(tcbPtrTbl[i]->taskStatus == 0)
 	        {
-	            uLipePrioSet(i, &taskPrioList);
+	            uLipeKernelTaskReady(tcbPtrTbl[i]);
 	        }
 		}
 
 	}while( i != 0);
 
 }
+#if OS_DEFERRED_POST_EN > 0
+/*
+ * SemGiveDeferred()
+ *
+ * Internal function, executes a give recorded by uLipeSemGiveFromISR()
+ */
+static void SemGiveDeferred(OsHandler_t h, uintptr_t arg)
+{
+	uLipeSemGive(h, (uint16_t)arg);
+}
+#endif
+
 /*
  * uLipeSemCreate()
  */
@@ -110,6 +128,9 @@ OsHandler_t uLipeSemCreate(uint16_t initCount, uint16_t limitCount,OsStatus_t *e
 	//Initalize this block:
 	s->semCount = initCount;
 	s->semLimit = limitCount;
+#if OS_SET_MODULE_EN > 0
+	s->set = NULL;
+#endif
 
 	//All gone well:
 	if(err != NULL) *err = kStatusOk;
@@ -117,9 +138,12 @@ OsHandler_t uLipeSemCreate(uint16_t initCount, uint16_t limitCount,OsStatus_t *e
 }
 
 /*
- * uLipeSemTake()
+ * uLipeSemPend()
+ *
+ * Internal function, takes a semaphore waiting up to a relative timeout
+ * or up to an absolute deadline tick.
  */
-OsStatus_t uLipeSemTake(OsHandler_t h, uint16_t timeout)
+static OsStatus_t uLipeSemPend(OsHandler_t h, uint32_t timeout, bool deadline)
 {
 	SemPtr_t s = (SemPtr_t)h;
 	uint32_t sReg = 0;
@@ -130,6 +154,8 @@ OsStatus_t uLipeSemTake(OsHandler_t h, uint16_t timeout)
 		return(kInvalidParam);
 	}
 
+	OS_TRACE(kTraceSemTake, h);
+
 	//Argument valid, proceed:
 	OS_CRITICAL_IN();
 
@@ -137,22 +163,20 @@ OsStatus_t uLipeSemTake(OsHandler_t h, uint16_t timeout)
 	{
 		//No semaphore key available, so...
 
-		OS_CRITICAL_OUT();
-
         currentTask->semBmp = &s->tasksWaiting;
 		uLipePrioSet(currentTask->taskPrio, &s->tasksWaiting);
 
-		OS_CRITICAL_IN();
-
 		//...suspend and add this task in wait list:
-		uLipePrioClr(currentTask->taskPrio, &taskPrioList);
+		uLipeKernelTaskUnready(currentTask);
 		//Add timeout amount:
         currentTask->taskStatus |= (1 << kTaskPendSem);
-        if(timeout != 0)
+        if(deadline != false)
         {
-            currentTask->taskStatus |= (1 << kTaskPendDelay);
-            currentTask->delayTime = timeout;
-            uLipePrioSet(currentTask->taskPrio, &timerPendingList.list[timerPendingList.activeList]);
+            uLipeKernelTimerStartAt(currentTask, timeout);
+        }
+        else if(timeout != 0)
+        {
+            uLipeKernelTimerStart(currentTask, timeout);
         }
 
 		OS_CRITICAL_OUT();
@@ -187,6 +211,22 @@ OsStatus_t uLipeSemTake(OsHandler_t h, uint16_t timeout)
 	return(kStatusOk);
 }
 
+/*
+ * uLipeSemTake()
+ */
+OsStatus_t uLipeSemTake(OsHandler_t h, uint32_t timeout)
+{
+	return(uLipeSemPend(h, timeout, false));
+}
+
+/*
+ * uLipeSemTakeUntil()
+ */
+OsStatus_t uLipeSemTakeUntil(OsHandler_t h, uint32_t deadline)
+{
+	return(uLipeSemPend(h, deadline, true));
+}
+
 /*
  * uLipeSemGive()
  */
@@ -202,6 +242,8 @@ OsStatus_t uLipeSemGive(OsHandler_t h, uint16_t count)
 		return(kInvalidParam);
 	}
 
+	OS_TRACE(kTraceSemGive, h);
+
 	//Arguments valid, proceed:
 	OS_CRITICAL_IN();
 
@@ -245,6 +287,14 @@ OsStatus_t uLipeSemDelete(OsHandler_t *h)
 	//Argument valid, proceed:
 	OS_CRITICAL_IN();
 
+#if OS_SET_MODULE_EN > 0
+	//unlink it from its set:
+	if(((SemPtr_t)*h)->set != NULL)
+	{
+		uLipeSetDetach(((SemPtr_t)*h)->set, *h);
+	}
+#endif
+
 	//Signal tasks which this sem will be deleted:
 	SemDeleteLoop(*h);
 	uLipeMemFree(s);
@@ -259,4 +309,21 @@ OsStatus_t uLipeSemDelete(OsHandler_t *h)
 	return(kStatusOk);
 }
 
+#if OS_DEFERRED_POST_EN > 0
+/*
+ * uLipeSemGiveFromISR()
+ */
+OsStatus_t uLipeSemGiveFromISR(OsHandler_t h, uint16_t count)
+{
+	//check arguments:
+	if(h == 0)
+	{
+		return(kInvalidParam);
+	}
+
+	//The give is executed when the outermost isr exits:
+	return(uLipeKernelDeferPost(&SemGiveDeferred, h, count));
+}
+#endif
+
 #endif
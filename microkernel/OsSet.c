@@ -0,0 +1,405 @@
+/*!
+ *
+ * 							ULIPE RTOS VERSION 4
+ *
+ *
+ *  \file OsSet.c
+ *
+ *  \brief this file contains the routines for object sets management
+ *
+ *	In this file the user will find the implementation of the object
+ *	sets, each member object keeps a link to its set and wakes the set
+ *	waiter when it is posted, the waiter checks the members itself, so
+ *	a member taken by another task before it runs is not reported.
+ *
+ *  Author: FSN
+ *
+ */
+
+#include "uLipeRtos4.h"
+
+#if OS_SET_MODULE_EN > 0
+
+/*
+ * Set internal macros:
+ */
+#define OS_SET_MEMBERS(s)	((SetMemberPtr_t)((s) + 1))
+
+/*
+ * Module implementation:
+ */
+
+/*
+ * uLipeSetLink()
+ *
+ * Internal function, gives the set link of a member object, NULL if the
+ * type is not known or its module is disabled.
+ */
+static SetPtr_t *uLipeSetLink(OsHandler_t h, uint8_t type)
+{
+	switch(type)
+	{
+#if OS_SEM_MODULE_EN > 0
+		case OS_SET_SEM:
+			return(&((SemPtr_t)h)->set);
+#endif
+#if OS_QUEUE_MODULE_EN > 0
+		case OS_SET_QUEUE:
+			return(&((QueuePtr_t)h)->set);
+#endif
+#if OS_FLAGS_MODULE_EN > 0
+		case OS_SET_FLAGS:
+			return(&((FlagsGrpPtr_t)h)->set);
+#endif
+#if OS_STREAM_MODULE_EN > 0
+		case OS_SET_STREAM:
+			return(&((StreamPtr_t)h)->set);
+#endif
+		default:
+			return(NULL);
+	}
+}
+
+/*
+ * uLipeSetReady()
+ *
+ * Internal function, checks if a member object can be taken without
+ * blocking, must be called with interrupts disabled.
+ */
+static bool uLipeSetReady(SetMemberPtr_t m)
+{
+	switch(m->type)
+	{
+#if OS_SEM_MODULE_EN > 0
+		case OS_SET_SEM:
+			return(((SemPtr_t)m->h)->semCount != 0);
+#endif
+#if OS_QUEUE_MODULE_EN > 0
+		case OS_SET_QUEUE:
+			return(((QueuePtr_t)m->h)->usedSlots != 0);
+#endif
+#if OS_FLAGS_MODULE_EN > 0
+		case OS_SET_FLAGS:
+			return((((FlagsGrpPtr_t)m->h)->flagRegister & m->mask) != 0);
+#endif
+#if OS_STREAM_MODULE_EN > 0
+		case OS_SET_STREAM:
+			return((((StreamPtr_t)m->h)->head - ((StreamPtr_t)m->h)->tail) >=
+				   ((StreamPtr_t)m->h)->trigger);
+#endif
+		default:
+			return(false);
+	}
+}
+
+/*
+ * uLipeSetPoll()
+ *
+ * Internal function, finds a ready member starting after the last one
+ * reported, must be called with interrupts disabled.
+ */
+static OsHandler_t uLipeSetPoll(SetPtr_t s)
+{
+	SetMemberPtr_t m = OS_SET_MEMBERS(s);
+	uint32_t i;
+	uint32_t j = s->nextMember;
+
+	for(i = 0; i < s->numMembers; i++)
+	{
+		if(j >= s->numMembers) j = 0;
+
+		if(uLipeSetReady(&m[j]))
+		{
+			s->nextMember = j + 1;
+			return(m[j].h);
+		}
+		j++;
+	}
+
+	return((OsHandler_t)NULL);
+}
+
+/*
+ * uLipeSetPend()
+ *
+ * Internal function, waits on a set up to a relative timeout or up to
+ * an absolute deadline tick.
+ */
+static OsHandler_t uLipeSetPend(OsHandler_t h, uint32_t timeout, bool deadline, OsStatus_t *err)
+{
+	uint32_t sReg = 0;
+	SetPtr_t s = (SetPtr_t)h;
+	OsHandler_t ret;
+	uint32_t ticks;
+	bool forever = (deadline == false) && (timeout == 0);
+
+	//check arguments:
+	if(h == 0)
+	{
+		if(err != NULL) *err = kInvalidParam;
+		return((OsHandler_t)NULL);
+	}
+
+	//a retry only waits for the time left:
+	if(deadline == false)
+	{
+		timeout += uLipeKernelTickGet();
+	}
+
+	OS_CRITICAL_IN();
+
+	//a single task waits on a set:
+	if(s->waiter != NULL)
+	{
+		OS_CRITICAL_OUT();
+		if(err != NULL) *err = kInvalidParam;
+		return((OsHandler_t)NULL);
+	}
+
+	ret = uLipeSetPoll(s);
+	while(ret == 0)
+	{
+		ticks = timeout - uLipeKernelTickGet();
+		if((forever == false) && ((ticks == 0) || (ticks > OS_DEADLINE_WINDOW)))
+		{
+			break;
+		}
+
+		s->waiter = currentTask;
+		uLipeKernelTaskUnready(currentTask);
+		currentTask->taskStatus |= (1 << kTaskPendSet);
+		if(forever == false)
+		{
+			uLipeKernelTimerStart(currentTask, ticks);
+		}
+
+		OS_CRITICAL_OUT();
+
+		//Task suspended, find a new task to run:
+		uLipeKernelTaskYield();
+
+		OS_CRITICAL_IN();
+
+		//woken by a member post or by timeout, check them again:
+		s->waiter = NULL;
+		ret = uLipeSetPoll(s);
+	}
+
+	OS_CRITICAL_OUT();
+
+	if(err != NULL) *err = (ret != 0) ? kStatusOk : kTimeout;
+	return(ret);
+}
+
+/*
+ * uLipeSetSignal()
+ */
+void uLipeSetSignal(SetPtr_t s)
+{
+	OsTCBPtr_t tcb = s->waiter;
+
+	if((tcb != NULL) && (tcb->taskStatus & (1 << kTaskPendSet)))
+	{
+		uLipeKernelTimerStop(tcb);
+		tcb->taskStatus &= ~(1 << kTaskPendSet);
+		if(tcb->taskStatus == 0)
+		{
+			uLipeKernelTaskReady(tcb);
+		}
+	}
+}
+
+/*
+ * uLipeSetDetach()
+ */
+void uLipeSetDetach(SetPtr_t s, OsHandler_t h)
+{
+	SetMemberPtr_t m = OS_SET_MEMBERS(s);
+	uint32_t i;
+
+	for(i = 0; i < s->numMembers; i++)
+	{
+		if(m[i].h == h) break;
+	}
+	if(i == s->numMembers) return;
+
+	*uLipeSetLink(h, m[i].type) = NULL;
+
+	//keep members order, so the round robin goes on:
+	s->numMembers--;
+	for(; i < s->numMembers; i++)
+	{
+		m[i] = m[i + 1];
+	}
+	if(s->nextMember > s->numMembers) s->nextMember = 0;
+}
+
+/*
+ * uLipeSetCreate()
+ */
+OsHandler_t uLipeSetCreate(uint32_t members, OsStatus_t *err)
+{
+	SetPtr_t s;
+
+	//check arguments before taking memory:
+	if((members == 0) || (members > 0xFFFF))
+	{
+		if(err != NULL) *err = kInvalidParam;
+		return((OsHandler_t)NULL);
+	}
+
+	if(members > ((OS_MAX_SIZED_HEAP_BLOCK - sizeof(Set_t)) / sizeof(SetMember_t)))
+	{
+		if(err != NULL) *err = kOutOfMem;
+		return((OsHandler_t)NULL);
+	}
+
+	s = uLipeMemAlloc(sizeof(Set_t) + (members * sizeof(SetMember_t)));
+	if(s == NULL)
+	{
+		if(err != NULL) *err = kOutOfMem;
+		return((OsHandler_t)NULL);
+	}
+
+	s->waiter = NULL;
+	s->maxMembers = (uint16_t)members;
+	s->numMembers = 0;
+	s->nextMember = 0;
+
+	if(err != NULL) *err = kStatusOk;
+	return((OsHandler_t)s);
+}
+
+/*
+ * uLipeSetAdd()
+ */
+OsStatus_t uLipeSetAdd(OsHandler_t set, OsHandler_t h, uint8_t type, uint32_t mask)
+{
+	uint32_t sReg = 0;
+	SetPtr_t s = (SetPtr_t)set;
+	SetPtr_t *link;
+	SetMemberPtr_t m;
+
+	//check arguments:
+	if((set == 0) || (h == 0) || ((type == OS_SET_FLAGS) && (mask == 0)))
+	{
+		return(kInvalidParam);
+	}
+
+	link = uLipeSetLink(h, type);
+	if(link == NULL)
+	{
+		return(kInvalidParam);
+	}
+
+	OS_CRITICAL_IN();
+
+	if(*link != NULL)
+	{
+		OS_CRITICAL_OUT();
+		return(kInvalidParam);
+	}
+
+	if(s->numMembers == s->maxMembers)
+	{
+		OS_CRITICAL_OUT();
+		return(kSetFull);
+	}
+
+	m = &OS_SET_MEMBERS(s)[s->numMembers++];
+	m->h = h;
+	m->mask = mask;
+	m->type = type;
+	*link = s;
+
+	//the object may be ready already:
+	uLipeSetSignal(s);
+
+	OS_CRITICAL_OUT();
+
+	//check for a context switch:
+	uLipeKernelTaskYield();
+
+	return(kStatusOk);
+}
+
+/*
+ * uLipeSetRemove()
+ */
+OsStatus_t uLipeSetRemove(OsHandler_t set, OsHandler_t h)
+{
+	uint32_t sReg = 0;
+
+	//check arguments:
+	if((set == 0) || (h == 0))
+	{
+		return(kInvalidParam);
+	}
+
+	OS_CRITICAL_IN();
+	uLipeSetDetach((SetPtr_t)set, h);
+	OS_CRITICAL_OUT();
+
+	return(kStatusOk);
+}
+
+/*
+ * uLipeSetWait()
+ */
+OsHandler_t uLipeSetWait(OsHandler_t set, uint32_t timeout, OsStatus_t *err)
+{
+	return(uLipeSetPend(set, timeout, false, err));
+}
+
+/*
+ * uLipeSetWaitUntil()
+ */
+OsHandler_t uLipeSetWaitUntil(OsHandler_t set, uint32_t deadline, OsStatus_t *err)
+{
+	return(uLipeSetPend(set, deadline, true, err));
+}
+
+/*
+ * uLipeSetDelete()
+ */
+OsStatus_t uLipeSetDelete(OsHandler_t *h)
+{
+	uint32_t sReg = 0;
+	SetPtr_t s;
+	SetMemberPtr_t m;
+	uint32_t i;
+
+	//check arguments:
+	if((h == NULL) || (*h == 0))
+	{
+		return(kInvalidParam);
+	}
+
+	s = (SetPtr_t)*h;
+	m = OS_SET_MEMBERS(s);
+
+	OS_CRITICAL_IN();
+
+	//the task waiting would resume on a freed set:
+	if(s->waiter != NULL)
+	{
+		OS_CRITICAL_OUT();
+		return(kInvalidParam);
+	}
+
+	//members are not posting to this set anymore:
+	for(i = 0; i < s->numMembers; i++)
+	{
+		*uLipeSetLink(m[i].h, m[i].type) = NULL;
+	}
+	uLipeMemFree(s);
+
+	OS_CRITICAL_OUT();
+
+	//Destroy reference for this control block:
+	*h = 0;
+
+	return(kStatusOk);
+}
+
+#endif
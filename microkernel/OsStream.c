@@ -0,0 +1,536 @@
+/*!
+ *
+ * 							ULIPE RTOS VERSION 4
+ *
+ *
+ *  \file OsStream.c
+ *
+ *  \brief this file contains the routines for stream buffers
+ *  management
+ *
+ *	In this file the user will find the implementation of the stream
+ *	buffers, unlike the ring buffers any number of tasks and isrs send
+ *	and receive under the kernel lock, blocked tasks wait on the stream
+ *	lists and timeouts clean them up as the other kernel objects.
+ *
+ *  Author: FSN
+ *
+ */
+
+#include "uLipeRtos4.h"
+
+#if OS_STREAM_MODULE_EN > 0
+
+/*
+ * Stream internal macros:
+ */
+#define OS_STREAM_BUFFER(s)	((uint8_t *)((s) + 1))
+
+/*
+ * External modules variables:
+ */
+extern OsTCBPtr_t tcbPtrTbl[];
+
+/*
+ * Module variables:
+ */
+static OsPrioList_t streamDeleted;	//wait list given to the waiters of a deleted stream
+
+/*
+ * Module implementation:
+ */
+
+/*
+ * uLipeStreamWake()
+ *
+ * Internal function, makes ready the highest priority task waiting on
+ * a stream list, it checks the stream again when it runs.
+ */
+static void uLipeStreamWake(OsPrioListPtr_t waitList)
+{
+	uint32_t i;
+
+	i = uLipeKernelFindHighPrio(waitList);
+	if(i != 0)
+	{
+		uLipePrioClr(i, waitList);
+
+		//make this task ready:
+		uLipeKernelTimerStop(tcbPtrTbl[i]);
+		tcbPtrTbl[i]->streamBmp = NULL;
+		tcbPtrTbl[i]->taskStatus &= ~(1 << kTaskPendStream);
+		if(tcbPtrTbl[i]->taskStatus == 0)
+		{
+			uLipeKernelTaskReady(tcbPtrTbl[i]);
+		}
+	}
+}
+
+/*
+ * uLipeStreamDeleteWake()
+ *
+ * Internal function, makes ready all tasks waiting on a stream list
+ * which is about to be destroyed, they see it when they run.
+ */
+static void uLipeStreamDeleteWake(OsPrioListPtr_t waitList)
+{
+	uint32_t i;
+
+	while(waitList->prioGrp != 0)
+	{
+		i = uLipeKernelFindHighPrio(waitList);
+		uLipePrioClr(i, waitList);
+
+		uLipeKernelTimerStop(tcbPtrTbl[i]);
+		tcbPtrTbl[i]->streamBmp = &streamDeleted;
+		tcbPtrTbl[i]->taskStatus &= ~(1 << kTaskPendStream);
+		if(tcbPtrTbl[i]->taskStatus == 0)
+		{
+			uLipeKernelTaskReady(tcbPtrTbl[i]);
+		}
+	}
+}
+
+/*
+ * uLipeStreamGone()
+ *
+ * Internal function, tells if the stream was deleted while current task
+ * waited on it, must be called with interrupts disabled.
+ */
+static bool uLipeStreamGone(void)
+{
+	if(currentTask->streamBmp != &streamDeleted)
+	{
+		return(false);
+	}
+
+	currentTask->streamBmp = NULL;
+	return(true);
+}
+
+/*
+ * uLipeStreamReadWake()
+ *
+ * Internal function, wakes the readers whose read fits on the bytes
+ * stored, must be called with interrupts disabled.
+ */
+static void uLipeStreamReadWake(StreamPtr_t s)
+{
+	uint32_t count = s->head - s->tail;
+
+	if(count >= s->trigger)
+	{
+		//any read waited fits, the first reader is enough:
+		uLipeStreamWake(&s->readWait);
+	}
+	else if(count >= s->readWant)
+	{
+		//only shorter reads fit and the shortest reader is not known,
+		//so all of them check it again:
+		while(s->readWait.prioGrp != 0)
+		{
+			uLipeStreamWake(&s->readWait);
+		}
+	}
+
+	//readers going back to wait record their reads again:
+	if(s->readWait.prioGrp == 0)
+	{
+		s->readWant = s->trigger;
+	}
+}
+
+/*
+ * uLipeStreamWait()
+ *
+ * Internal function, blocks current task on a wait list of a stream
+ * up to an absolute tick, returns false without blocking if that tick
+ * was already reached, must be called with interrupts disabled.
+ */
+static bool uLipeStreamWait(OsPrioListPtr_t waitList, bool forever, uint32_t deadline)
+{
+	uint32_t ticks = deadline - uLipeKernelTickGet();
+
+	if((forever == false) && ((ticks == 0) || (ticks > OS_DEADLINE_WINDOW)))
+	{
+		return(false);
+	}
+
+	uLipeKernelTaskUnready(currentTask);
+	currentTask->taskStatus |= (1 << kTaskPendStream);
+	currentTask->streamBmp = waitList;
+	uLipePrioSet(currentTask->taskPrio, waitList);
+
+	if(forever == false)
+	{
+		uLipeKernelTimerStart(currentTask, ticks);
+	}
+
+	return(true);
+}
+
+/*
+ * uLipeStreamPut()
+ *
+ * Internal function, copies bytes after the write index, there must be
+ * space for them, must be called with interrupts disabled.
+ */
+static void uLipeStreamPut(StreamPtr_t s, const uint8_t *data, uint32_t len)
+{
+	uint32_t offset = s->head & s->mask;
+	uint32_t first = (s->mask + 1) - offset;
+
+	//two spans when the bytes wrap around the storage end:
+	if(first > len) first = len;
+
+	memcpy(OS_STREAM_BUFFER(s) + offset, data, first);
+	memcpy(OS_STREAM_BUFFER(s), data + first, len - first);
+	s->head += len;
+
+	//a reader is only woken when the trigger level, or its shorter
+	//read, is reached:
+	uLipeStreamReadWake(s);
+
+#if OS_SET_MODULE_EN > 0
+	//a task waiting on a set checks it again:
+	if(((s->head - s->tail) >= s->trigger) && (s->set != NULL))
+	{
+		uLipeSetSignal(s->set);
+	}
+#endif
+}
+
+/*
+ * uLipeStreamGet()
+ *
+ * Internal function, copies and removes bytes after the read index, they
+ * must be stored, must be called with interrupts disabled.
+ */
+static void uLipeStreamGet(StreamPtr_t s, uint8_t *data, uint32_t len)
+{
+	uint32_t offset = s->tail & s->mask;
+	uint32_t first = (s->mask + 1) - offset;
+
+	if(first > len) first = len;
+
+	memcpy(data, OS_STREAM_BUFFER(s) + offset, first);
+	memcpy(data + first, OS_STREAM_BUFFER(s), len - first);
+	s->tail += len;
+}
+
+/*
+ * uLipeStreamCreate()
+ */
+OsHandler_t uLipeStreamCreate(uint32_t size, uint32_t trigger, OsStatus_t *err)
+{
+	StreamPtr_t s;
+
+	//check arguments before taking memory:
+	if((size == 0) || ((size & (size - 1)) != 0) || (trigger == 0) || (trigger > size))
+	{
+		if(err != NULL) *err = kInvalidParam;
+		return((OsHandler_t)NULL);
+	}
+
+	if(size > (OS_MAX_SIZED_HEAP_BLOCK - sizeof(Stream_t)))
+	{
+		if(err != NULL) *err = kOutOfMem;
+		return((OsHandler_t)NULL);
+	}
+
+	s = uLipeMemAlloc(sizeof(Stream_t) + size);
+	if(s == NULL)
+	{
+		if(err != NULL) *err = kOutOfMem;
+		return((OsHandler_t)NULL);
+	}
+
+	s->head = 0;
+	s->tail = 0;
+	s->mask = size - 1;
+	s->trigger = trigger;
+	s->readWant = trigger;
+	memset(&s->readWait, 0, sizeof(OsPrioList_t));
+	memset(&s->writeWait, 0, sizeof(OsPrioList_t));
+#if OS_SET_MODULE_EN > 0
+	s->set = NULL;
+#endif
+
+	if(err != NULL) *err = kStatusOk;
+	return((OsHandler_t)s);
+}
+
+/*
+ * uLipeStreamSend()
+ */
+uint32_t uLipeStreamSend(OsHandler_t h, const void *data, uint32_t len, uint8_t opt,
+						 uint32_t timeout, OsStatus_t *err)
+{
+	uint32_t sReg = 0;
+	StreamPtr_t s = (StreamPtr_t)h;
+	OsStatus_t status = kStatusOk;
+	bool forever = (timeout == 0) ? true : false;
+	uint32_t ret = 0;
+	uint32_t room;
+
+	//check arguments:
+	if((h == 0) || ((data == NULL) && (len != 0)))
+	{
+		if(err != NULL) *err = kInvalidParam;
+		return(0);
+	}
+
+	OS_CRITICAL_IN();
+
+	//relative timeout is taken as a deadline, so each wait for space
+	//takes only what is left:
+	timeout += uLipeKernelTickGet();
+
+	for(;;)
+	{
+		room = (s->mask + 1) - (s->head - s->tail);
+		if(room > (len - ret)) room = len - ret;
+		if(room != 0)
+		{
+			uLipeStreamPut(s, (const uint8_t *)data + ret, room);
+			ret += room;
+		}
+
+		if(ret == len) break;
+
+		if(opt != OS_STREAM_BLOCK)
+		{
+			status = kQueueFull;
+			break;
+		}
+
+		if(uLipeStreamWait(&s->writeWait, forever, timeout) == false)
+		{
+			status = kTimeout;
+			break;
+		}
+
+		OS_CRITICAL_OUT();
+
+		//Task suspended, find a new task to run:
+		uLipeKernelTaskYield();
+
+		OS_CRITICAL_IN();
+
+		//the stream was deleted while the task waited:
+		if(uLipeStreamGone())
+		{
+			OS_CRITICAL_OUT();
+			if(err != NULL) *err = kInvalidParam;
+			return(ret);
+		}
+	}
+
+	//space left goes to the next sender:
+	if((s->head - s->tail) <= s->mask)
+	{
+		uLipeStreamWake(&s->writeWait);
+	}
+
+	OS_CRITICAL_OUT();
+
+	//check for a context switch, in a isr it is done on its exit:
+	uLipeKernelTaskYield();
+
+	if(err != NULL) *err = status;
+	return(ret);
+}
+
+/*
+ * uLipeStreamReceive()
+ */
+uint32_t uLipeStreamReceive(OsHandler_t h, void *data, uint32_t len, uint8_t opt,
+							uint32_t timeout, OsStatus_t *err)
+{
+	uint32_t sReg = 0;
+	StreamPtr_t s = (StreamPtr_t)h;
+	bool forever = (timeout == 0) ? true : false;
+	uint32_t want;
+	uint32_t ret;
+
+	//check arguments:
+	if((h == 0) || ((data == NULL) && (len != 0)))
+	{
+		if(err != NULL) *err = kInvalidParam;
+		return(0);
+	}
+
+	OS_CRITICAL_IN();
+
+	timeout += uLipeKernelTickGet();
+
+	//a short read does not wait for the whole trigger level:
+	want = (len < s->trigger) ? len : s->trigger;
+
+	while(((s->head - s->tail) < want) && (opt == OS_STREAM_BLOCK))
+	{
+		//on timeout the bytes stored are taken:
+		if(uLipeStreamWait(&s->readWait, forever, timeout) == false)
+		{
+			break;
+		}
+
+		//senders wake the readers at this level:
+		if(want < s->readWant)
+		{
+			s->readWant = want;
+		}
+
+		OS_CRITICAL_OUT();
+
+		//Task suspended, find a new task to run:
+		uLipeKernelTaskYield();
+
+		OS_CRITICAL_IN();
+
+		//the stream was deleted while the task waited:
+		if(uLipeStreamGone())
+		{
+			OS_CRITICAL_OUT();
+			if(err != NULL) *err = kInvalidParam;
+			return(0);
+		}
+	}
+
+	ret = s->head - s->tail;
+	if(ret > len) ret = len;
+	if(ret != 0)
+	{
+		uLipeStreamGet(s, (uint8_t *)data, ret);
+		uLipeStreamWake(&s->writeWait);
+	}
+
+	//bytes left go to the next receiver:
+	uLipeStreamReadWake(s);
+
+	OS_CRITICAL_OUT();
+
+	//check for a context switch:
+	uLipeKernelTaskYield();
+
+	if(err != NULL)
+	{
+		if((ret != 0) || (len == 0)) *err = kStatusOk;
+		else *err = (opt == OS_STREAM_BLOCK) ? kTimeout : kQueueEmpty;
+	}
+	return(ret);
+}
+
+/*
+ * uLipeStreamPeek()
+ */
+uint32_t uLipeStreamPeek(OsHandler_t h, void **span)
+{
+	uint32_t sReg = 0;
+	StreamPtr_t s = (StreamPtr_t)h;
+	uint32_t offset;
+	uint32_t ret;
+
+	//check arguments:
+	if((h == 0) || (span == NULL)) return(0);
+
+	OS_CRITICAL_IN();
+
+	offset = s->tail & s->mask;
+
+	//stored bytes up to the write index or up to the storage end:
+	ret = s->head - s->tail;
+	if(ret > ((s->mask + 1) - offset)) ret = (s->mask + 1) - offset;
+
+	OS_CRITICAL_OUT();
+
+	*span = OS_STREAM_BUFFER(s) + offset;
+	return(ret);
+}
+
+/*
+ * uLipeStreamConsume()
+ */
+OsStatus_t uLipeStreamConsume(OsHandler_t h, uint32_t len)
+{
+	uint32_t sReg = 0;
+	StreamPtr_t s = (StreamPtr_t)h;
+
+	//check arguments:
+	if(h == 0) return(kInvalidParam);
+
+	OS_CRITICAL_IN();
+
+	if((len > (s->head - s->tail)) || (len > ((s->mask + 1) - (s->tail & s->mask))))
+	{
+		OS_CRITICAL_OUT();
+		return(kInvalidParam);
+	}
+
+	if(len != 0)
+	{
+		s->tail += len;
+		uLipeStreamWake(&s->writeWait);
+	}
+
+	OS_CRITICAL_OUT();
+
+	//check for a context switch:
+	uLipeKernelTaskYield();
+
+	return(kStatusOk);
+}
+
+/*
+ * uLipeStreamCount()
+ */
+uint32_t uLipeStreamCount(OsHandler_t h)
+{
+	StreamPtr_t s = (StreamPtr_t)h;
+
+	//check arguments:
+	if(h == 0) return(0);
+
+	return(s->head - s->tail);
+}
+
+/*
+ * uLipeStreamDelete()
+ */
+OsStatus_t uLipeStreamDelete(OsHandler_t *h)
+{
+	uint32_t sReg = 0;
+
+	//check arguments:
+	if((h == NULL) || (*h == 0))
+	{
+		return(kInvalidParam);
+	}
+
+	OS_CRITICAL_IN();
+
+#if OS_SET_MODULE_EN > 0
+	//unlink it from its set:
+	if(((StreamPtr_t)*h)->set != NULL)
+	{
+		uLipeSetDetach(((StreamPtr_t)*h)->set, *h);
+	}
+#endif
+
+	//tasks waiting on it return with an error:
+	uLipeStreamDeleteWake(&((StreamPtr_t)*h)->readWait);
+	uLipeStreamDeleteWake(&((StreamPtr_t)*h)->writeWait);
+	uLipeMemFree(*h);
+
+	OS_CRITICAL_OUT();
+
+	//Destroy reference for this control block:
+	*h = 0;
+
+	//check for a context switch:
+	uLipeKernelTaskYield();
+
+	return(kStatusOk);
+}
+
+#endif
@@ -26,15 +26,19 @@
  * Module variables:
  */
 
-OsTCBPtr_t  tcbPtrTbl[OS_NUMBER_OF_TASKS]= {0};		//Array of tcb pointers to external access
+OsTCBPtr_t  tcbPtrTbl[OS_TASK_SLOTS]= {0};		//Array of tcb pointers to external access
 uint16_t tasksCount={0};							//count of installed tasks.
+static OsTCBPtr_t deadTask[OS_NUMBER_OF_CORES] = {0};	//deleted by itself, freed on next delete
 
 /*
  * External variables
  */
-extern OsPrioList_t taskPrioList;
-extern OsTCBPtr_t   currentTask;
-extern OsDualPrioList_t timerPendingList;
+#if OS_ROUND_ROBIN_EN > 0
+extern uint16_t timeSlice[];
+#endif
+#if OS_TASK_STATS_EN > 0
+extern uint32_t statsSwitchStamp[];
+#endif
 
 /*
  * Module implementation:
@@ -42,10 +46,26 @@ extern OsDualPrioList_t timerPendingList;
 
 
 /*
- * 	ulipeTaskCreate()
+ * 	ulipeTaskFree()
+ *
+ * 	Internal function, releases the memory of a deleted task, it must not
+ * 	be running.
  */
-OsStatus_t uLipeTaskCreate(void (*task) (void * args), uint32_t stackSize,
-                           uint16_t taskPrio, void *taskArgs)
+static void uLipeTaskFree(OsTCBPtr_t tcb)
+{
+	uLipePortStackFree(tcb->stackTop);
+	uLipeMemFree(tcb->stackBase);
+	uLipeMemFree(tcb);
+}
+
+/*
+ * 	ulipeTaskInstall()
+ *
+ * 	Internal function, creates a task, relDeadline is not 0 only for the
+ * 	tasks of edf band.
+ */
+static OsStatus_t uLipeTaskInstall(void (*task) (void * args), uint32_t stackSize,
+                                   uint16_t taskPrio, uint32_t relDeadline, void *taskArgs)
 {
 
 	extern void uLipeTaskEntry(void *);
@@ -53,6 +73,11 @@ OsStatus_t uLipeTaskCreate(void (*task) (void * args), uint32_t stackSize,
 	OsTCBPtr_t tcb = uLipeMemAlloc(sizeof(OsTCB_t));
 	OsStackPtr_t sp = uLipeMemAlloc(sizeof(uint32_t) * stackSize);
 
+	uint16_t id;
+#if OS_STACK_MONITOR_EN > 0
+	uint32_t i;
+#endif
+
 	//Check arguments:
 	if(task == NULL) return(kInvalidParam);
 	if(taskPrio > (OS_NUMBER_OF_TASKS - 1)) return(kInvalidParam);
@@ -72,14 +97,20 @@ OsStatus_t uLipeTaskCreate(void (*task) (void * args), uint32_t stackSize,
         return(kOutOfMem);
 	}
 
-	if(tasksCount >= OS_NUMBER_OF_TASKS)
+	if(tasksCount >= OS_TASK_SLOTS)
 	{
 		OS_CRITICAL_OUT();
 		return(kOutOfTasks);
 	}
 
-	//Check if prio was used:
-	if(tcbPtrTbl[taskPrio] != NULL)
+	//Take the first free slot of this prio:
+	for(id = OS_TASK_ID(taskPrio, 0); id < OS_TASK_ID(taskPrio + 1, 0); id++)
+	{
+		if(tcbPtrTbl[id] == NULL) break;
+	}
+
+	//Check if all slots of this prio were used:
+	if(id == OS_TASK_ID(taskPrio + 1, 0))
 	{
 		OS_CRITICAL_OUT();
         uLipeMemFree(tcb);
@@ -93,18 +124,71 @@ OsStatus_t uLipeTaskCreate(void (*task) (void * args), uint32_t stackSize,
 
 
 	//Take this tcb
-	tcb->taskPrio  = taskPrio;
+	tcb->taskPrio  = id;
+	tcb->runPrio   = taskPrio;
+	tcb->stackBase = sp;
+
+#if OS_STACK_MONITOR_EN > 0
+	//paint the whole stack, the words still painted were never used:
+	tcb->stackSize = stackSize;
+	for(i = 0; i < stackSize; i++)
+	{
+		sp[i] = OS_STACK_PAINT;
+	}
+#endif
+#if OS_STACK_OVERFLOW_CHECK_EN > 0
+	sp[0] = OS_STACK_CANARY;
+#endif
+
 	//Initialize the stack frame:
 	tcb->stackTop = uLipeStackInit(sp + stackSize, &uLipeTaskEntry, taskArgs);
 	tcb->task = task;
 	tcb->taskStatus = 0;
+	tcb->readyNext = NULL;
+	tcb->readyPrev = NULL;
+	tcb->mtxBmp = NULL;
+	tcb->flagsBmp = NULL;
+	tcb->queueBmp = NULL;
+	tcb->semBmp = NULL;
+#if OS_STREAM_MODULE_EN > 0
+	tcb->streamBmp = NULL;
+#endif
+#if OS_MTX_MODULE_EN > 0
+	tcb->mtxHeld = NULL;
+	tcb->mtxWait = NULL;
+#endif
+#if OS_TASK_BUDGET_EN > 0
+	tcb->budget = 0;
+	tcb->budgetOverruns = 0;
+	tcb->budgetExhausted = FALSE;
+	tcb->budgetNext = NULL;
+#endif
+#if OS_EDF_EN > 0
+	tcb->relDeadline = relDeadline;
+	tcb->deadline = 0;
+	tcb->deadlineMisses = 0;
+	tcb->jobActive = FALSE;
+#else
+	(void)relDeadline;
+#endif
+#if OS_ARCH_MULTICORE > 0
+	tcb->coreId = 0;
+	tcb->affinity = OS_CORE_ALL;
+#endif
+#if OS_TASK_STATS_EN > 0
+	memset(&tcb->stats, 0, sizeof(OsTaskStats_t));
+#endif
+#if OS_TASK_NOTIFY_EN > 0
+	tcb->notifyValue = 0;
+	tcb->notifyPending = FALSE;
+#endif
 
 
 	//Attach the tcb in linked list:
-	tcbPtrTbl[taskPrio] = tcb;
+	tcbPtrTbl[id] = tcb;
 
 	//all ready, lets make this task ready to run:
-	uLipePrioSet(taskPrio, &taskPrioList);
+	uLipeKernelTaskReady(tcb);
 
     OS_CRITICAL_OUT();
 
@@ -114,6 +198,45 @@ OsStatus_t uLipeTaskCreate(void (*task) (void * args), uint32_t stackSize,
 	return(kStatusOk);
 }
 
+/*
+ * 	ulipeTaskCreate()
+ */
+OsStatus_t uLipeTaskCreate(void (*task) (void * args), uint32_t stackSize,
+                           uint16_t taskPrio, void *taskArgs)
+{
+	return(uLipeTaskInstall(task, stackSize, taskPrio, 0, taskArgs));
+}
+
+#if OS_EDF_EN > 0
+/*
+ * 	ulipeTaskCreateEdf()
+ */
+OsStatus_t uLipeTaskCreateEdf(void (*task) (void * args), uint32_t stackSize,
+                              uint32_t relDeadline, void *taskArgs)
+{
+	if((relDeadline == 0) || (relDeadline > OS_DEADLINE_WINDOW)) return(kInvalidParam);
+
+	return(uLipeTaskInstall(task, stackSize, OS_EDF_PRIO, relDeadline, taskArgs));
+}
+
+/*
+ * 	ulipeTaskDeadlineMisses()
+ */
+OsStatus_t uLipeTaskDeadlineMisses( uint16_t taskPrio, uint32_t *misses)
+{
+	//Check arguments:
+	if(misses == NULL) return(kInvalidParam);
+	if(taskPrio > (OS_TASK_SLOTS - 1)) return(kInvalidParam);
+	if(tcbPtrTbl[taskPrio] == NULL) return(kInvalidParam);
+	if(tcbPtrTbl[taskPrio]->relDeadline == 0) return(kInvalidParam);
+
+	//a single word, no need of critical section:
+	*misses = tcbPtrTbl[taskPrio]->deadlineMisses;
+
+	return(kStatusOk);
+}
+#endif
+
 /*
  * 	ulipeTaskDelete()
  */
@@ -127,11 +250,46 @@ OsStatus_t uLipeTaskDelete( uint16_t taskPrio)
 
 	OS_CRITICAL_IN();
 	tcb = tcbPtrTbl[taskPrio];
+
+#if OS_ARCH_MULTICORE > 0
+	//its context is in use by other core, suspend it first:
+	if((tcb->coreId != OS_CORE_ID()) && (osCoreCurrentTask[tcb->coreId] == tcb))
+	{
+		OS_CRITICAL_OUT();
+		return(kInvalidParam);
+	}
+#endif
+
 	tcbPtrTbl[taskPrio] = NULL;
-	//Remove task from ready list first:
-	uLipePrioClr(taskPrio, &taskPrioList);
-    uLipeMemFree(tcb->stackTop);
-	uLipeMemFree(tcb);
+	tasksCount--;
+#if OS_TASK_BUDGET_EN > 0
+	//leaves the budgeted list before the ready one:
+	uLipeKernelBudgetSet(tcb, 0, 0, 0);
+#endif
+	//Remove task from ready list and timer wheel first:
+	uLipeKernelTaskUnready(tcb);
+	uLipeKernelTimerStop(tcb);
+#if OS_MTX_MODULE_EN > 0
+	uLipeMutexTaskDelete(tcb);
+#endif
+
+	//a task deleted before by itself on this core was switched out:
+	if((deadTask[OS_CORE_ID()] != NULL) && (deadTask[OS_CORE_ID()] != currentTask))
+	{
+		uLipeTaskFree(deadTask[OS_CORE_ID()]);
+		deadTask[OS_CORE_ID()] = NULL;
+	}
+
+	if(tcb == currentTask)
+	{
+		//it still runs on its stack and the switch saves its context
+		//on tcb, so both are freed on next delete:
+		deadTask[OS_CORE_ID()] = tcb;
+	}
+	else
+	{
+		uLipeTaskFree(tcb);
+	}
 
 	OS_CRITICAL_OUT();
 
@@ -141,6 +299,14 @@ OsStatus_t uLipeTaskDelete( uint16_t taskPrio)
 	return(kStatusOk);
 }
 
+/*
+ * 	ulipeTaskSelf()
+ */
+uint16_t uLipeTaskSelf(void)
+{
+	return(currentTask->taskPrio);
+}
+
 /*
  * 	ulipeTaskSuspend()
  */
@@ -155,7 +321,7 @@ OsStatus_t uLipeTaskSuspend( uint16_t taskPrio)
 	OS_CRITICAL_IN();
 
 	//First remove this task from ready list:
-	uLipePrioClr(taskPrio, &taskPrioList);
+	uLipeKernelTaskUnready(tcbPtrTbl[taskPrio]);
 	tcbPtrTbl[taskPrio]->taskStatus |=  (1 << kTaskSuspend);
 
 	//Task suspended, then find a new task to run:
@@ -183,7 +349,7 @@ OsStatus_t uLipeTaskResume( uint16_t taskPrio)
 	tcbPtrTbl[taskPrio]->taskStatus &=  ~(1 << kTaskSuspend);
     if(tcbPtrTbl[taskPrio]->taskStatus == 0)
     {
-        uLipePrioSet(taskPrio, &taskPrioList);
+        uLipeKernelTaskReady(tcbPtrTbl[taskPrio]);
     }
 
 	//Task resumed, check the ready list:
@@ -197,7 +363,7 @@ OsStatus_t uLipeTaskResume( uint16_t taskPrio)
 /*
  * 	ulipeTaskDelay()
  */
-OsStatus_t uLipeTaskDelay( uint16_t ticks)
+OsStatus_t uLipeTaskDelay( uint32_t ticks)
 {
 	uint32_t sReg = 0;
 
@@ -206,12 +372,10 @@ OsStatus_t uLipeTaskDelay( uint16_t ticks)
 	    OS_CRITICAL_IN();
 
 	    //Remove the current task from the ready list:
-	    uLipePrioClr(currentTask->taskPrio, &taskPrioList);
-	    currentTask->taskStatus |=  (1 << kTaskPendDelay);
+	    uLipeKernelTaskUnready(currentTask);
 
 	    //Put the delay value:
-	    currentTask->delayTime = ticks;
-        uLipePrioSet(currentTask->taskPrio, &timerPendingList.list[timerPendingList.activeList]);
+	    uLipeKernelTimerStart(currentTask, ticks);
 
 	    OS_CRITICAL_OUT();
 
@@ -222,3 +386,330 @@ OsStatus_t uLipeTaskDelay( uint16_t ticks)
 
 	return(kStatusOk);
 }
+
+/*
+ * 	ulipeTaskDelayUntil()
+ */
+OsStatus_t uLipeTaskDelayUntil( uint32_t *lastWake, uint32_t period)
+{
+	uint32_t sReg = 0;
+	uint32_t ticks;
+
+	//Check arguments:
+	if((lastWake == NULL) || (period == 0)) return(kInvalidParam);
+
+	OS_CRITICAL_IN();
+
+	//next release comes from the previous one, the time spent by the
+	//task between the calls does not accumulate:
+	*lastWake += period;
+	ticks = *lastWake - uLipeKernelTickGet();
+
+	//release missed, keep the phase and let the caller catch up:
+	if((ticks == 0) || (ticks > OS_DEADLINE_WINDOW))
+	{
+		OS_CRITICAL_OUT();
+		return(kTimeout);
+	}
+
+	uLipeKernelTaskUnready(currentTask);
+	uLipeKernelTimerStart(currentTask, ticks);
+
+	OS_CRITICAL_OUT();
+
+	//Task suspended, check the ready list, find a new task:
+	uLipeKernelTaskYield();
+
+	return(kStatusOk);
+}
+
+#if OS_TASK_NOTIFY_EN > 0
+/*
+ * 	ulipeTaskNotify()
+ */
+OsStatus_t uLipeTaskNotify( uint16_t taskPrio, uint32_t value, OsNotifyAction_t action)
+{
+	uint32_t sReg = 0;
+	OsTCBPtr_t tcb;
+
+	//Check arguments:
+	if(taskPrio > (OS_TASK_SLOTS - 1)) return(kInvalidParam);
+	if(tcbPtrTbl[taskPrio] == NULL) return(kInvalidParam);
+
+	OS_CRITICAL_IN();
+	tcb = tcbPtrTbl[taskPrio];
+
+	switch(action)
+	{
+		case kNotifySetBits:
+			tcb->notifyValue |= value;
+		break;
+
+		case kNotifyIncrement:
+			tcb->notifyValue++;
+		break;
+
+		case kNotifyOverwrite:
+			tcb->notifyValue = value;
+		break;
+
+		default:
+			OS_CRITICAL_OUT();
+			return(kInvalidParam);
+	}
+
+	tcb->notifyPending = TRUE;
+
+	//Only the target task is woken, if it is waiting:
+	if(tcb->taskStatus & (1 << kTaskPendNotify))
+	{
+		uLipeKernelTimerStop(tcb);
+		tcb->taskStatus &= ~(1 << kTaskPendNotify);
+		if(tcb->taskStatus == 0)
+		{
+			uLipeKernelTaskReady(tcb);
+		}
+	}
+
+	OS_CRITICAL_OUT();
+
+	//check for a context switching:
+	uLipeKernelTaskYield();
+
+	return(kStatusOk);
+}
+
+/*
+ * 	ulipeTaskNotifyPend()
+ *
+ * 	Internal function, waits a notification up to a relative timeout or
+ * 	up to an absolute deadline tick.
+ */
+static OsStatus_t uLipeTaskNotifyPend( uint32_t clearMask, uint32_t *value, uint32_t timeout, bool deadline)
+{
+	uint32_t sReg = 0;
+
+	OS_CRITICAL_IN();
+
+	if(currentTask->notifyPending == FALSE)
+	{
+		//Nothing was notified, suspend the task:
+		uLipeKernelTaskUnready(currentTask);
+		currentTask->taskStatus |= (1 << kTaskPendNotify);
+		if(deadline != false)
+		{
+			uLipeKernelTimerStartAt(currentTask, timeout);
+		}
+		else if(timeout != 0)
+		{
+			uLipeKernelTimerStart(currentTask, timeout);
+		}
+
+		OS_CRITICAL_OUT();
+
+		//Task suspended, find a new task to run:
+		uLipeKernelTaskYield();
+
+		OS_CRITICAL_IN();
+
+		//woken by timeout:
+		if(currentTask->notifyPending == FALSE)
+		{
+			OS_CRITICAL_OUT();
+			return(kTimeout);
+		}
+	}
+
+	//Consume the notification:
+	if(value != NULL) *value = currentTask->notifyValue;
+	currentTask->notifyValue &= ~clearMask;
+	currentTask->notifyPending = FALSE;
+
+	OS_CRITICAL_OUT();
+
+	return(kStatusOk);
+}
+
+/*
+ * 	ulipeTaskNotifyWait()
+ */
+OsStatus_t uLipeTaskNotifyWait( uint32_t clearMask, uint32_t *value, uint32_t timeout)
+{
+	return(uLipeTaskNotifyPend(clearMask, value, timeout, false));
+}
+
+/*
+ * 	ulipeTaskNotifyWaitUntil()
+ */
+OsStatus_t uLipeTaskNotifyWaitUntil( uint32_t clearMask, uint32_t *value, uint32_t deadline)
+{
+	return(uLipeTaskNotifyPend(clearMask, value, deadline, true));
+}
+#endif
+
+#if OS_STACK_MONITOR_EN > 0
+/*
+ * 	ulipeTaskStackUsage()
+ */
+OsStatus_t uLipeTaskStackUsage( uint16_t taskPrio, uint32_t *used, uint32_t *size)
+{
+	OsTCBPtr_t tcb;
+	uint32_t i;
+
+	//Check arguments:
+	if(used == NULL) return(kInvalidParam);
+	if(taskPrio > (OS_TASK_SLOTS - 1)) return(kInvalidParam);
+	if(tcbPtrTbl[taskPrio] == NULL) return(kInvalidParam);
+
+	tcb = tcbPtrTbl[taskPrio];
+
+	i = 0;
+#if OS_STACK_OVERFLOW_CHECK_EN > 0
+	//the first word holds the canary:
+	i = 1;
+#endif
+
+	//stack grows down, find the lowest word already written:
+	while((i < tcb->stackSize) && (tcb->stackBase[i] == OS_STACK_PAINT))
+	{
+		i++;
+	}
+
+	*used = tcb->stackSize - i;
+	if(size != NULL) *size = tcb->stackSize;
+
+	return(kStatusOk);
+}
+#endif
+
+#if OS_TASK_STATS_EN > 0
+/*
+ * 	ulipeTaskStats()
+ */
+OsStatus_t uLipeTaskStats( uint16_t taskPrio, OsTaskStats_t *stats)
+{
+	uint32_t sReg = 0;
+	uint16_t core = 0;
+	OsTCBPtr_t tcb;
+
+	//Check arguments:
+	if(stats == NULL) return(kInvalidParam);
+	if(taskPrio > (OS_TASK_SLOTS - 1)) return(kInvalidParam);
+	if(tcbPtrTbl[taskPrio] == NULL) return(kInvalidParam);
+
+	OS_CRITICAL_IN();
+	tcb = tcbPtrTbl[taskPrio];
+	*stats = tcb->stats;
+
+#if OS_ARCH_MULTICORE > 0
+	core = tcb->coreId;
+#endif
+
+	//running task, account what was consumed up to now:
+	if(tcb == OS_CORE_CURRENT(core))
+	{
+		stats->runCycles += (uint32_t)(uLipePortCycleCount() - statsSwitchStamp[core]);
+	}
+	OS_CRITICAL_OUT();
+
+	return(kStatusOk);
+}
+#endif
+
+#if OS_ROUND_ROBIN_EN > 0
+/*
+ * 	ulipeTaskTimeSlice()
+ */
+OsStatus_t uLipeTaskTimeSlice( uint16_t taskPrio, uint16_t ticks)
+{
+	uint32_t sReg = 0;
+
+	//Check arguments:
+	if(taskPrio > (OS_NUMBER_OF_TASKS - 1)) return(kInvalidParam);
+
+	OS_CRITICAL_IN();
+	timeSlice[taskPrio] = ticks;
+	OS_CRITICAL_OUT();
+
+	return(kStatusOk);
+}
+#endif
+
+#if OS_TASK_BUDGET_EN > 0
+/*
+ * 	ulipeTaskBudget()
+ */
+OsStatus_t uLipeTaskBudget( uint16_t taskPrio, uint32_t budget, uint32_t period, uint8_t opt)
+{
+	uint32_t sReg = 0;
+
+	//Check arguments:
+	if(taskPrio > (OS_TASK_SLOTS - 1)) return(kInvalidParam);
+	if(tcbPtrTbl[taskPrio] == NULL) return(kInvalidParam);
+	if(OS_TASK_PRIO(taskPrio) == OS_LEAST_PRIO) return(kInvalidParam);
+	if((opt & ~OS_BUDGET_DEMOTE) != 0) return(kInvalidParam);
+	if((budget != 0) && ((period < budget) || (period > OS_DEADLINE_WINDOW))) return(kInvalidParam);
+
+	OS_CRITICAL_IN();
+	uLipeKernelBudgetSet(tcbPtrTbl[taskPrio], budget, period, opt);
+	OS_CRITICAL_OUT();
+
+	//a throttled task may be ready again:
+	uLipeKernelTaskYield();
+
+	return(kStatusOk);
+}
+
+/*
+ * 	ulipeTaskBudgetOverruns()
+ */
+OsStatus_t uLipeTaskBudgetOverruns( uint16_t taskPrio, uint32_t *overruns)
+{
+	//Check arguments:
+	if(overruns == NULL) return(kInvalidParam);
+	if(taskPrio > (OS_TASK_SLOTS - 1)) return(kInvalidParam);
+	if(tcbPtrTbl[taskPrio] == NULL) return(kInvalidParam);
+	if(tcbPtrTbl[taskPrio]->budget == 0) return(kInvalidParam);
+
+	//a single word, no need of critical section:
+	*overruns = tcbPtrTbl[taskPrio]->budgetOverruns;
+
+	return(kStatusOk);
+}
+#endif
+
+#if OS_ARCH_MULTICORE > 0
+/*
+ * 	ulipeTaskAffinity()
+ */
+OsStatus_t uLipeTaskAffinity( uint16_t taskPrio, uint32_t coreMask)
+{
+	uint32_t sReg = 0;
+	OsTCBPtr_t tcb;
+
+	//Check arguments:
+	if(taskPrio > (OS_TASK_SLOTS - 1)) return(kInvalidParam);
+	if(tcbPtrTbl[taskPrio] == NULL) return(kInvalidParam);
+	if((coreMask == 0) || ((coreMask & ~OS_CORE_ALL) != 0)) return(kInvalidParam);
+
+	OS_CRITICAL_IN();
+	tcb = tcbPtrTbl[taskPrio];
+	tcb->affinity = coreMask;
+
+	//a task waiting on the ready list of a core no longer allowed moves
+	//now, the running one moves when it becomes ready again:
+	if((tcb->readyNext != NULL) && ((coreMask & (1UL << tcb->coreId)) == 0) &&
+	   (osCoreCurrentTask[tcb->coreId] != tcb))
+	{
+		uLipeKernelTaskUnready(tcb);
+		uLipeKernelTaskReady(tcb);
+	}
+
+	OS_CRITICAL_OUT();
+
+	//check for a context switching:
+	uLipeKernelTaskYield();
+
+	return(kStatusOk);
+}
+#endif
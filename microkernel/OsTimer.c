@@ -0,0 +1,402 @@
+/*!
+ *
+ * 							ULIPE RTOS VERSION 4
+ *
+ *
+ *  \file OsTimer.c
+ *
+ *  \brief this file contains the routines for software timers
+ *  management
+ *
+ *	In this file the user will find the implementation of the software
+ *	timers, running timers are hashed on a wheel by its expiration tick
+ *	like the delayed tasks, the tick moves the expired ones to a list
+ *	and the daemon task calls all of them on a single wake up.
+ *
+ *  Author: FSN
+ *
+ */
+
+#include "uLipeRtos4.h"
+
+#if OS_TIMER_MODULE_EN > 0
+
+/*
+ * Module variables:
+ */
+static TimerPtr_t timerBuckets[OS_TIMER_WHEEL_SIZE]; //running timers
+static TimerPtr_t expiredHead;                       //timers waiting the daemon
+static TimerPtr_t expiredTail;                       //
+static OsTCBPtr_t timerDaemon;                       //daemon tcb, once it runs
+
+/*
+ * Module implementation:
+ */
+
+/*
+ * uLipeTimerInsert()
+ *
+ * Internal function, puts a timer on the wheel, each bucket is sorted by
+ * the distance to expiration.
+ */
+static void uLipeTimerInsert(TimerPtr_t t, uint32_t expiry)
+{
+	uint32_t now = uLipeKernelTickGet();
+	uint32_t ticks = expiry - now;
+	TimerPtr_t *bucket = &timerBuckets[expiry & OS_TIMER_WHEEL_MASK];
+	TimerPtr_t prev = NULL;
+	TimerPtr_t next = *bucket;
+
+	while((next != NULL) && ((next->expiry - now) <= ticks))
+	{
+		prev = next;
+		next = next->next;
+	}
+
+	t->expiry = expiry;
+	t->state = kTimerActive;
+	t->prev = prev;
+	t->next = next;
+	if(next != NULL) next->prev = t;
+	if(prev != NULL) prev->next = t;
+	else *bucket = t;
+}
+
+/*
+ * uLipeTimerUnlink()
+ *
+ * Internal function, takes a timer out of the wheel or out of the daemon
+ * list, a stopped timer is not linked anywhere.
+ */
+static void uLipeTimerUnlink(TimerPtr_t t)
+{
+	if(t->state == kTimerActive)
+	{
+		if(t->prev != NULL) t->prev->next = t->next;
+		else timerBuckets[t->expiry & OS_TIMER_WHEEL_MASK] = t->next;
+		if(t->next != NULL) t->next->prev = t->prev;
+	}
+	else if(t->state == kTimerExpired)
+	{
+		if(t->prev != NULL) t->prev->next = t->next;
+		else expiredHead = t->next;
+		if(t->next != NULL) t->next->prev = t->prev;
+		else expiredTail = t->prev;
+	}
+
+	t->next = NULL;
+	t->prev = NULL;
+	t->state = kTimerStopped;
+}
+
+/*
+ * uLipeTimerAppend()
+ *
+ * Internal function, puts an expired timer on the tail of the daemon list,
+ * so callbacks are called in the order they expired.
+ */
+static void uLipeTimerAppend(TimerPtr_t t)
+{
+	t->state = kTimerExpired;
+	t->next = NULL;
+	t->prev = expiredTail;
+	if(expiredTail != NULL) expiredTail->next = t;
+	else expiredHead = t;
+	expiredTail = t;
+}
+
+/*
+ * uLipeTimerDaemon()
+ *
+ * Internal function, timer daemon task, calls the expired timers in
+ * the order they expired and sleeps when there are no more of them.
+ */
+static void uLipeTimerDaemon(void *args)
+{
+	uint32_t sReg = 0;
+	uint32_t ticks;
+	TimerPtr_t t;
+	OsTimerCallback_t callback;
+	void *arg;
+
+	(void)args;
+
+	OS_CRITICAL_IN();
+	timerDaemon = currentTask;
+	OS_CRITICAL_OUT();
+
+	for(;;)
+	{
+		OS_CRITICAL_IN();
+
+		t = expiredHead;
+		if(t == NULL)
+		{
+			//batch done, the tick wakes us on next expirations:
+			uLipeKernelTaskUnready(currentTask);
+			currentTask->taskStatus |= (1 << kTaskPendTimer);
+			OS_CRITICAL_OUT();
+
+			uLipeKernelTaskYield();
+			continue;
+		}
+
+		uLipeTimerUnlink(t);
+		callback = t->callback;
+		arg = t->arg;
+
+		//periodic timers are rearmed before the call, so the callback
+		//can stop or reset it, the period is kept from the last expiry:
+		if(t->opt & OS_TIMER_PERIODIC)
+		{
+			ticks = (t->expiry + t->period) - uLipeKernelTickGet();
+			if((ticks == 0) || (ticks > OS_DEADLINE_WINDOW))
+			{
+				//daemon is late, the missed period is called on this batch:
+				t->expiry += t->period;
+				uLipeTimerAppend(t);
+			}
+			else
+			{
+				uLipeTimerInsert(t, t->expiry + t->period);
+			}
+		}
+
+		OS_CRITICAL_OUT();
+
+		callback((OsHandler_t)t, arg);
+	}
+}
+
+/*
+ * uLipeTimerInit()
+ */
+OsStatus_t uLipeTimerInit(void)
+{
+	uint32_t i;
+
+	for(i = 0; i < OS_TIMER_WHEEL_SIZE; i++)
+	{
+		timerBuckets[i] = NULL;
+	}
+	expiredHead = NULL;
+	expiredTail = NULL;
+	timerDaemon = NULL;
+
+	return(uLipeTaskCreate(&uLipeTimerDaemon, OS_TIMER_DAEMON_STACK_SIZE,
+						   OS_TIMER_DAEMON_PRIO, NULL));
+}
+
+/*
+ * uLipeTimerTick()
+ */
+void uLipeTimerTick(uint32_t tick)
+{
+	TimerPtr_t *bucket = &timerBuckets[tick & OS_TIMER_WHEEL_MASK];
+	TimerPtr_t t;
+
+	//bucket is sorted, timers of next wheel turns stays on its tail:
+	while((*bucket != NULL) && ((*bucket)->expiry == tick))
+	{
+		t = *bucket;
+		uLipeTimerUnlink(t);
+		uLipeTimerAppend(t);
+	}
+
+	//a single wake up for the whole batch:
+	if((expiredHead != NULL) && (timerDaemon != NULL) &&
+	   (timerDaemon->taskStatus & (1 << kTaskPendTimer)))
+	{
+		timerDaemon->taskStatus &= ~(1 << kTaskPendTimer);
+		if(timerDaemon->taskStatus == 0)
+		{
+			uLipeKernelTaskReady(timerDaemon);
+		}
+	}
+}
+
+#if OS_TICKLESS_IDLE_EN > 0
+/*
+ * uLipeTimerNextTimeout()
+ */
+uint32_t uLipeTimerNextTimeout(void)
+{
+	uint32_t now = uLipeKernelTickGet();
+	uint32_t ret = OS_TICKLESS_NO_TIMEOUT;
+	uint32_t distance;
+	uint32_t i;
+	TimerPtr_t t;
+
+	//same walk of the task wheel, the first bucket which expires on
+	//its own tick holds the earliest timer:
+	for(i = 1; i <= OS_TIMER_WHEEL_SIZE; i++)
+	{
+		t = timerBuckets[(now + i) & OS_TIMER_WHEEL_MASK];
+		if(t == NULL) continue;
+
+		distance = t->expiry - now;
+		if(distance == i) return(distance);
+
+		if(distance < ret) ret = distance;
+	}
+
+	return(ret);
+}
+#endif
+
+/*
+ * uLipeTimerCreateStatic()
+ */
+OsHandler_t uLipeTimerCreateStatic(Timer_t *t, OsTimerCallback_t callback, void *arg,
+								   uint32_t period, uint8_t opt, OsStatus_t *err)
+{
+	//check arguments:
+	if((t == NULL) || (callback == NULL) || (period == 0) ||
+	   ((opt & ~OS_TIMER_PERIODIC) != 0))
+	{
+		if(err != NULL) *err = kInvalidParam;
+		return((OsHandler_t)NULL);
+	}
+
+	t->next = NULL;
+	t->prev = NULL;
+	t->callback = callback;
+	t->arg = arg;
+	t->expiry = 0;
+	t->period = period;
+	t->opt = opt;
+	t->state = kTimerStopped;
+
+	if(err != NULL) *err = kStatusOk;
+	return((OsHandler_t)t);
+}
+
+/*
+ * uLipeTimerCreate()
+ */
+OsHandler_t uLipeTimerCreate(OsTimerCallback_t callback, void *arg, uint32_t period,
+							 uint8_t opt, OsStatus_t *err)
+{
+	TimerPtr_t t;
+
+	//check arguments before taking memory:
+	if((callback == NULL) || (period == 0) || ((opt & ~OS_TIMER_PERIODIC) != 0))
+	{
+		if(err != NULL) *err = kInvalidParam;
+		return((OsHandler_t)NULL);
+	}
+
+	t = uLipeMemAlloc(sizeof(Timer_t));
+	if(t == NULL)
+	{
+		if(err != NULL) *err = kOutOfTimer;
+		return((OsHandler_t)NULL);
+	}
+
+	uLipeTimerCreateStatic(t, callback, arg, period, opt, err);
+	t->opt |= OS_TIMER_HEAP;
+	return((OsHandler_t)t);
+}
+
+/*
+ * uLipeTimerStart()
+ */
+OsStatus_t uLipeTimerStart(OsHandler_t h)
+{
+	uint32_t sReg = 0;
+	TimerPtr_t t = (TimerPtr_t)h;
+
+	//check arguments:
+	if(h == 0)
+	{
+		return(kInvalidParam);
+	}
+
+	OS_CRITICAL_IN();
+
+	//an expired timer not called yet is considered running:
+	if(t->state == kTimerStopped)
+	{
+		uLipeTimerInsert(t, uLipeKernelTickGet() + t->period);
+	}
+
+	OS_CRITICAL_OUT();
+
+	//no task is made ready here, a ctx swt is not needed:
+	return(kStatusOk);
+}
+
+/*
+ * uLipeTimerReset()
+ */
+OsStatus_t uLipeTimerReset(OsHandler_t h)
+{
+	uint32_t sReg = 0;
+	TimerPtr_t t = (TimerPtr_t)h;
+
+	//check arguments:
+	if(h == 0)
+	{
+		return(kInvalidParam);
+	}
+
+	OS_CRITICAL_IN();
+	uLipeTimerUnlink(t);
+	uLipeTimerInsert(t, uLipeKernelTickGet() + t->period);
+	OS_CRITICAL_OUT();
+
+	return(kStatusOk);
+}
+
+/*
+ * uLipeTimerStop()
+ */
+OsStatus_t uLipeTimerStop(OsHandler_t h)
+{
+	uint32_t sReg = 0;
+	TimerPtr_t t = (TimerPtr_t)h;
+
+	//check arguments:
+	if(h == 0)
+	{
+		return(kInvalidParam);
+	}
+
+	OS_CRITICAL_IN();
+	uLipeTimerUnlink(t);
+	OS_CRITICAL_OUT();
+
+	return(kStatusOk);
+}
+
+/*
+ * uLipeTimerDelete()
+ */
+OsStatus_t uLipeTimerDelete(OsHandler_t *h)
+{
+	uint32_t sReg = 0;
+	TimerPtr_t t;
+
+	//check arguments:
+	if((h == NULL) || (*h == 0))
+	{
+		return(kInvalidParam);
+	}
+
+	t = (TimerPtr_t)*h;
+
+	OS_CRITICAL_IN();
+	uLipeTimerUnlink(t);
+	if(t->opt & OS_TIMER_HEAP)
+	{
+		uLipeMemFree(t);
+	}
+	OS_CRITICAL_OUT();
+
+	//Destroy reference for this control block:
+	*h = 0;
+
+	return(kStatusOk);
+}
+
+#endif
@@ -0,0 +1,91 @@
+/*!
+ *
+ * 							ULIPE RTOS VERSION 4
+ *
+ *
+ *  \file OsTrace.c
+ *
+ *  \brief this file contains the kernel trace recorder
+ *
+ *	In this file the user will find the implementation of the trace
+ *	ring buffer, records are timestamped with the cpu cycle counter
+ *
+ *  Author: FSN
+ */
+
+#include "uLipeRtos4.h"
+
+#if OS_TRACE_EN > 0
+
+/*
+ * Module variables:
+ */
+OsTraceBuffer_t osTraceBuffer;			//trace ring buffer, dump this symbol
+static uint8_t traceEnabled = FALSE;	//recording is active
+
+/*
+ * Module implementation:
+ */
+
+/*
+ * uLipeTraceInit()
+ */
+void uLipeTraceInit(void)
+{
+	uint32_t sReg = 0;
+
+	OS_CRITICAL_IN();
+
+	memset(&osTraceBuffer, 0, sizeof(osTraceBuffer));
+	osTraceBuffer.magic = OS_TRACE_MAGIC;
+	osTraceBuffer.version = OS_TRACE_VERSION;
+	osTraceBuffer.recordSize = sizeof(OsTraceRecord_t);
+	osTraceBuffer.size = OS_TRACE_BUFFER_SIZE;
+	osTraceBuffer.cpuRate = OS_CPU_RATE;
+	traceEnabled = TRUE;
+
+	OS_CRITICAL_OUT();
+}
+
+/*
+ * uLipeTraceRecord()
+ */
+void uLipeTraceRecord(OsTraceEvent_t event, uint32_t arg)
+{
+	uint32_t sReg = 0;
+	OsTraceRecordPtr_t r;
+
+	if(traceEnabled == FALSE) return;
+
+	OS_CRITICAL_IN();
+
+	//take the next record, the oldest one is overwritten:
+	r = &osTraceBuffer.records[osTraceBuffer.head & OS_TRACE_MASK];
+	osTraceBuffer.head++;
+
+	r->timeStamp = uLipePortCycleCount();
+	r->taskId = (currentTask != NULL) ? currentTask->taskPrio : OS_TRACE_NO_TASK;
+	r->event = (uint8_t)event;
+	r->reserved = 0;
+	r->arg = arg;
+
+	OS_CRITICAL_OUT();
+}
+
+/*
+ * uLipeTraceStart()
+ */
+void uLipeTraceStart(void)
+{
+	traceEnabled = TRUE;
+}
+
+/*
+ * uLipeTraceStop()
+ */
+void uLipeTraceStop(void)
+{
+	traceEnabled = FALSE;
+}
+
+#endif
@@ -16,6 +16,7 @@
 
 #include "uLipeRtos4.h"
 #include "include/arch/OsArch_Defs_M0.h"
+#include "include/arch/OsArch_Systick.h"
 
 #if (OS_ARCH_CORTEX_M0 == 1)
 
@@ -91,6 +92,54 @@ OsStackPtr_t uLipeStackInit(OsStackPtr_t taskStk, void * task, void *taskArgs )
 	return((OsStackPtr_t)ptr);
 }
 
+/*
+ *  uLipePortStackFree()
+ */
+void uLipePortStackFree(OsStackPtr_t taskStk)
+{
+	//the task stack is on kernel heap, nothing else to release:
+	(void)taskStk;
+}
+
+#if OS_TICKLESS_IDLE_EN > 0
+/*
+ *  uLipePortTicklessSleep()
+ */
+uint32_t uLipePortTicklessSleep(uint32_t ticks)
+{
+	return(uLipePortSystickSleep(ticks, OS_TIMER_LOAD_VAL));
+}
+#endif
+
+#if OS_CYCLE_COUNTER_EN > 0
+/*
+ *  uLipePortCycleCount()
+ */
+uint32_t uLipePortCycleCount(void)
+{
+	extern volatile uint32_t tickCounter;
+	uint32_t sReg;
+	uint32_t ticks;
+	uint32_t val;
+
+	//No cycle counter on M0, the systick is used as one, as it runs
+	//from the core clock:
+	OS_CRITICAL_IN();
+	ticks = tickCounter;
+	val = SysTick->VAL;
+
+	//timer reloaded but its irq was not processed yet:
+	if(SCB->ICSR & OS_PORT_ICSR_PENDSTSET)
+	{
+		val = SysTick->VAL;
+		ticks++;
+	}
+	OS_CRITICAL_OUT();
+
+	return((ticks * OS_TIMER_LOAD_VAL) + (OS_TIMER_LOAD_VAL - val));
+}
+#endif
+
 /*
  *  uLipePortChange()
  */
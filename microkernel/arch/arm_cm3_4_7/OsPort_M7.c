@@ -16,6 +16,7 @@
 
 #include "uLipeRtos4.h"
 #include "include/arch/OsArch_Defs_M3_M4_M7.h"
+#include "include/arch/OsArch_Systick.h"
 
 #if (OS_ARCH_CORTEX_M7 == 1) || (OS_ARCH_CORTEX_M4 == 1) || (OS_ARCH_CORTEX_M3 == 1)
 
@@ -24,6 +25,9 @@
  */
 #define OS_TIMER_LOAD_VAL (uint32_t)(OS_CPU_RATE/OS_TICK_RATE)
 
+#if OS_CYCLE_COUNTER_EN > 0
+static uint8_t dwtCycCntRunning = FALSE;	//dwt present and counting
+#endif
 
 
 /*
@@ -49,6 +53,24 @@ void uLipeInitMachine(void)
 	SCB->SHP[11] = 0xFF;
 	SCB->SHP[7]  = 0xFF;
 
+#if OS_ARCH_FPU_EN > 0
+	//Enable the fpu and the lazy stacking of its context, the
+	//fp registers are only saved when a task really used them:
+	SCB->CPACR |= OS_PORT_CPACR_FPU_FULL;
+	FPU->FPCCR |= OS_PORT_FPCCR_ASPEN | OS_PORT_FPCCR_LSPEN;
+#endif
+
+#if OS_CYCLE_COUNTER_EN > 0
+	//Start the dwt cycle counter, used by statistics and trace:
+	DEMCR |= OS_PORT_DEMCR_TRCENA;
+	DWT->LAR = OS_PORT_DWT_LAR_KEY;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= OS_PORT_DWT_CYCCNTENA;
+
+	//emulators (qemu) do not model the dwt, check if it really counts:
+	__asm volatile ("nop \n nop \n nop \n nop");
+	dwtCycCntRunning = (DWT->CYCCNT != 0) ? TRUE : FALSE;
+#endif
 
 	//Enable systick interrupts, ann use external clock source:
 	SysTick->CTRL |= 0x07;
@@ -65,7 +87,10 @@ OsStackPtr_t uLipeStackInit(OsStackPtr_t taskStk, void * task, void *taskArgs )
 	//Initialize the stkpointer on first free top position
 	ptr = (ArmCm4RegListPtr_t)taskStk - 1;
 
-	ptr->lr = 0xFFFFFFFD;			//Adds exec return on link reg
+	ptr->lr = OS_PORT_EXC_RETURN_THREAD;	//Adds exec return on link reg
+#if OS_ARCH_FPU_EN > 0
+	ptr->excReturn = OS_PORT_EXC_RETURN_THREAD; //tasks start without fp context
+#endif
 	ptr->pc = (uint32_t)task;		//task function at pc
 	ptr->xPsr = 0x01000000;			//xPsr default value with interrupts enabled
 	ptr->r0  = (uint32_t)taskArgs;	//Task arguments are passed thru R0
@@ -88,6 +113,55 @@ OsStackPtr_t uLipeStackInit(OsStackPtr_t taskStk, void * task, void *taskArgs )
 	return((OsStackPtr_t)ptr);
 }
 
+/*
+ *  uLipePortStackFree()
+ */
+void uLipePortStackFree(OsStackPtr_t taskStk)
+{
+	//the task stack is on kernel heap, nothing else to release:
+	(void)taskStk;
+}
+
+#if OS_TICKLESS_IDLE_EN > 0
+/*
+ *  uLipePortTicklessSleep()
+ */
+uint32_t uLipePortTicklessSleep(uint32_t ticks)
+{
+	return(uLipePortSystickSleep(ticks, OS_TIMER_LOAD_VAL));
+}
+#endif
+
+#if OS_CYCLE_COUNTER_EN > 0
+/*
+ *  uLipePortCycleCount()
+ */
+uint32_t uLipePortCycleCount(void)
+{
+	extern volatile uint32_t tickCounter;
+	uint32_t sReg;
+	uint32_t ticks;
+	uint32_t val;
+
+	if(dwtCycCntRunning != FALSE) return(DWT->CYCCNT);
+
+	//No dwt, the systick is used as one, as it runs from the core clock:
+	OS_CRITICAL_IN();
+	ticks = tickCounter;
+	val = SysTick->VAL;
+
+	//timer reloaded but its irq was not processed yet:
+	if(SCB->ICSR & OS_PORT_ICSR_PENDSTSET)
+	{
+		val = SysTick->VAL;
+		ticks++;
+	}
+	OS_CRITICAL_OUT();
+
+	return((ticks * OS_TIMER_LOAD_VAL) + (OS_TIMER_LOAD_VAL - val));
+}
+#endif
+
 /*
  *  uLipePortChange()
  */
@@ -0,0 +1,486 @@
+/*!
+ *
+ * 							ULIPE RTOS VERSION 4
+ *
+ *
+ *  \file OsPort_Posix.c
+ *
+ *  \brief this file is contains the functions of host dependent code
+ *
+ *	In this file the kernel runs as a linux process, tasks are ucontext
+ *	coroutines, the tick comes from a SIGALRM timer and critical sections
+ *	block that signal, the user should not call these routines.
+ *
+ *	On multicore each core is a host thread, the inter core irq is a
+ *	SIGUSR1 sent to the thread of that core, tasks may migrate between
+ *	threads, so host calls which take locks, as printf, must be done
+ *	inside of a critical section.
+ *
+ *  Author: FSN
+ *
+ */
+
+#include "uLipeRtos4.h"
+#include "include/arch/OsArch_Defs_Posix.h"
+
+#if (OS_ARCH_POSIX == 1)
+
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#if OS_ARCH_MULTICORE > 0
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/*
+ * Tick period in us and ns:
+ */
+#define OS_TICK_PERIOD_US	(1000000UL / OS_TICK_RATE)
+#define OS_TICK_PERIOD_NS	(OS_PORT_NSEC_PER_SEC / OS_TICK_RATE)
+
+/*
+ * Longest sleep allowed on tickless idle:
+ */
+#define OS_TICKLESS_MAX_TICKS	(uint32_t)(OS_TICK_RATE * 60)
+
+/*
+ * Module variables:
+ */
+static sigset_t irqSet;						//signals masked by critical sections
+static volatile uint32_t isrNesting[OS_NUMBER_OF_CORES];	//inside of signal handler
+static volatile uint8_t switchPending[OS_NUMBER_OF_CORES];	//context switch requested
+
+#if OS_ARCH_MULTICORE > 0
+static pthread_t coreThread[OS_NUMBER_OF_CORES];	//host thread of each core
+static __thread uint16_t coreId = 0;		//core of calling host thread
+static volatile uint8_t spinLock = 0;		//kernel spinlock
+#endif
+
+/*
+ * External modules variables:
+ */
+extern uint8_t osRunning;
+extern void uLipeKernelRtosTick(void);
+
+/*
+ * Functions implementation:
+ */
+
+#if OS_ARCH_MULTICORE > 0
+/*
+ *  uLipePortCoreId()
+ */
+__attribute__((noinline)) uint16_t uLipePortCoreId(void)
+{
+	//never inlined, a task resumed by other thread must not use
+	//the thread storage address taken before the switch:
+	return(coreId);
+}
+
+/*
+ *  uLipePortSwitch()
+ */
+static void uLipePortSwitch(void)
+{
+	uint32_t sReg;
+	uint16_t core;
+	OsTCBPtr_t from;
+	OsTCBPtr_t next;
+
+	sReg = uLipeKernelLockIn();
+	core = uLipePortCoreId();
+	switchPending[core] = FALSE;
+
+	//selects again, other cores may have changed the ready list:
+	from = osCoreCurrentTask[core];
+	next = uLipeKernelCoreNextTask();
+	if(next == from)
+	{
+		uLipeKernelLockOut(sReg);
+		return;
+	}
+
+#if (OS_TASK_STATS_EN > 0) || (OS_TRACE_EN > 0)
+	uLipeKernelSwitchHook();
+#endif
+
+	//the lock is handed to the task switched in, so no other core
+	//resumes this one before its context is saved:
+	osCoreCurrentTask[core] = next;
+	swapcontext(&((PosixCtxPtr_t)from->stackTop)->uc,
+				&((PosixCtxPtr_t)next->stackTop)->uc);
+
+	//resumed by any core, releases the lock it took:
+	uLipeKernelLockOut(sReg);
+}
+#else
+/*
+ *  uLipePortSwitch()
+ */
+static void uLipePortSwitch(void)
+{
+	OsTCBPtr_t from = currentTask;
+
+	switchPending[0] = FALSE;
+	if(highPrioTask == currentTask) return;
+
+#if (OS_TASK_STATS_EN > 0) || (OS_TRACE_EN > 0)
+	uLipeKernelSwitchHook();
+#endif
+
+	//the same sequence of pendSv, but the cpu state is saved by the
+	//host library on the task context:
+	currentTask = highPrioTask;
+	swapcontext(&((PosixCtxPtr_t)from->stackTop)->uc,
+				&((PosixCtxPtr_t)currentTask->stackTop)->uc);
+}
+#endif
+
+/*
+ *  uLipePortTaskEntry()
+ */
+static void uLipePortTaskEntry(void)
+{
+	PosixCtxPtr_t ctx;
+
+#if OS_ARCH_MULTICORE > 0
+	//releases the lock handed by the core which switched it in:
+	uLipeKernelLockOut(0);
+#endif
+
+	//makecontext only passes int arguments, so the entry point
+	//and its pointer argument are taken from task context:
+	ctx = (PosixCtxPtr_t)currentTask->stackTop;
+	ctx->entry(ctx->args);
+}
+
+/*
+ *  uLipePortIrq()
+ */
+static void uLipePortIrq(int sig)
+{
+	uint16_t core = OS_CORE_ID();
+
+	isrNesting[core]++;
+	if(sig == OS_PORT_TICK_SIGNAL)
+	{
+		uLipeKernelRtosTick();
+	}
+	else
+	{
+		//inter core irq, only reschedules this core:
+		uLipeKernelIrqIn();
+		uLipeKernelIrqOut();
+	}
+	isrNesting[core]--;
+
+	//the switch is done at handler exit, as pendSv would do:
+	if((switchPending[core] != FALSE) && (isrNesting[core] == 0)) uLipePortSwitch();
+}
+
+/*
+ *  uLipeEnterCritical()
+ */
+uint32_t uLipeEnterCritical(void)
+{
+	sigset_t old;
+
+	sigprocmask(SIG_BLOCK, &irqSet, &old);
+
+	//non zero if the tick was already masked:
+	return((uint32_t)sigismember(&old, OS_PORT_TICK_SIGNAL));
+}
+
+/*
+ *  uLipeExitCritical()
+ */
+void uLipeExitCritical(uint32_t sReg)
+{
+	uint16_t core;
+
+	//nested section, keeps the tick masked:
+	if(sReg != 0) return;
+
+	//a switch requested inside of the section is taken before the
+	//tick is unmasked, this task resumes here, maybe on other core:
+	core = OS_CORE_ID();
+	if((switchPending[core] != FALSE) && (isrNesting[core] == 0)) uLipePortSwitch();
+
+	sigprocmask(SIG_UNBLOCK, &irqSet, NULL);
+}
+
+/*
+ *  uLipeInitMachine()
+ */
+void uLipeInitMachine(void)
+{
+	struct sigaction sa;
+
+	sigemptyset(&irqSet);
+	sigaddset(&irqSet, OS_PORT_TICK_SIGNAL);
+#if OS_ARCH_MULTICORE > 0
+	sigaddset(&irqSet, OS_PORT_CORE_SIGNAL);
+#endif
+
+	//install the handlers, they cannot nest with each other:
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = &uLipePortIrq;
+	sa.sa_mask = irqSet;
+	sigaction(OS_PORT_TICK_SIGNAL, &sa, NULL);
+#if OS_ARCH_MULTICORE > 0
+	sigaction(OS_PORT_CORE_SIGNAL, &sa, NULL);
+#endif
+}
+
+/*
+ *  uLipePortCtxInit()
+ *
+ *  Internal function, prepares the host context of a task, it is kept
+ *  apart so no local of the caller lives across getcontext().
+ */
+static bool uLipePortCtxInit(PosixCtxPtr_t ctx)
+{
+	getcontext(&ctx->uc);
+	ctx->uc.uc_stack.ss_sp = malloc(OS_PORT_HOST_STACK_SIZE);
+	ctx->uc.uc_stack.ss_size = OS_PORT_HOST_STACK_SIZE;
+	ctx->uc.uc_link = NULL;
+
+	if(ctx->uc.uc_stack.ss_sp == NULL) return(FALSE);
+
+#if OS_ARCH_MULTICORE > 0
+	//tasks start holding the kernel lock, so masked, the entry
+	//releases the lock and unmasks the signals:
+	ctx->uc.uc_sigmask = irqSet;
+#else
+	//tasks start with the tick unmasked:
+	sigemptyset(&ctx->uc.uc_sigmask);
+#endif
+	makecontext(&ctx->uc, &uLipePortTaskEntry, 0);
+
+	return(TRUE);
+}
+
+/*
+ *  uLipeStackInit()
+ */
+OsStackPtr_t uLipeStackInit(OsStackPtr_t taskStk, void * task, void *taskArgs )
+{
+	PosixCtxPtr_t ctx;
+
+	//kernel stack is too small for host library calls, the task
+	//runs on its own host stack:
+	(void)taskStk;
+
+	ctx = (PosixCtxPtr_t)malloc(sizeof(PosixCtx_t));
+	if(ctx == NULL) return(NULL);
+
+	memset(ctx, 0, sizeof(PosixCtx_t));
+	ctx->entry = (void (*)(void *))task;
+	ctx->args = taskArgs;
+
+	if(uLipePortCtxInit(ctx) == FALSE)
+	{
+		free(ctx);
+		return(NULL);
+	}
+
+	//the context takes the place of stack pointer on tcb:
+	return((OsStackPtr_t)ctx);
+}
+
+/*
+ *  uLipePortStackFree()
+ */
+void uLipePortStackFree(OsStackPtr_t taskStk)
+{
+	PosixCtxPtr_t ctx = (PosixCtxPtr_t)taskStk;
+
+	//the task is switched out, so its host stack is not in use:
+	free(ctx->uc.uc_stack.ss_sp);
+	free(ctx);
+}
+
+#if OS_ARCH_MULTICORE > 0
+/*
+ *  uLipePortCoreStart()
+ */
+static void *uLipePortCoreStart(void *arg)
+{
+	//the thread inherits the signals masked by core 0:
+	coreId = (uint16_t)(uintptr_t)arg;
+
+	//its first task was selected by core 0 and releases the lock:
+	uLipeKernelLockIn();
+	setcontext(&((PosixCtxPtr_t)osCoreCurrentTask[coreId]->stackTop)->uc);
+
+	return(NULL);
+}
+#endif
+
+/*
+ *  uLipePortStartKernel()
+ */
+void uLipePortStartKernel(void)
+{
+	struct itimerval tick;
+#if OS_ARCH_MULTICORE > 0
+	uint16_t core;
+
+	uLipeKernelLockIn();
+
+	//all the first tasks are taken before any core runs:
+	coreThread[0] = pthread_self();
+	for(core = 0; core < OS_NUMBER_OF_CORES; core++)
+	{
+		osCoreCurrentTask[core] = osCoreHighPrioTask[core];
+	}
+#else
+	uLipeEnterCritical();
+
+	currentTask = highPrioTask;
+#endif
+	osRunning = TRUE;
+
+	//start the periodic tick:
+	tick.it_interval.tv_sec = 0;
+	tick.it_interval.tv_usec = OS_TICK_PERIOD_US;
+	tick.it_value = tick.it_interval;
+	setitimer(ITIMER_REAL, &tick, NULL);
+
+#if OS_ARCH_MULTICORE > 0
+	//core 0 runs on caller thread:
+	for(core = 1; core < OS_NUMBER_OF_CORES; core++)
+	{
+		pthread_create(&coreThread[core], NULL, &uLipePortCoreStart,
+					   (void *)(uintptr_t)core);
+	}
+#endif
+
+	//the caller context is never resumed:
+	setcontext(&((PosixCtxPtr_t)currentTask->stackTop)->uc);
+}
+
+#if OS_TICKLESS_IDLE_EN > 0
+/*
+ *  uLipePortTicklessSleep()
+ */
+uint32_t uLipePortTicklessSleep(uint32_t ticks)
+{
+	struct itimerval tick;
+	struct timespec req;
+	struct timespec start;
+	struct timespec end;
+	uint64_t elapsed;
+
+	if(ticks > OS_TICKLESS_MAX_TICKS) ticks = OS_TICKLESS_MAX_TICKS;
+
+	//Stop the tick:
+	memset(&tick, 0, sizeof(tick));
+	setitimer(ITIMER_REAL, &tick, NULL);
+
+	//sleep until the deadline or any other signal:
+	req.tv_sec = (time_t)(((uint64_t)ticks * OS_TICK_PERIOD_NS) / OS_PORT_NSEC_PER_SEC);
+	req.tv_nsec = (long)(((uint64_t)ticks * OS_TICK_PERIOD_NS) % OS_PORT_NSEC_PER_SEC);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	nanosleep(&req, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	//account only the whole elapsed ticks:
+	elapsed = ((uint64_t)(end.tv_sec - start.tv_sec) * OS_PORT_NSEC_PER_SEC) +
+				(uint64_t)end.tv_nsec - (uint64_t)start.tv_nsec;
+	elapsed /= OS_TICK_PERIOD_NS;
+	if(elapsed < ticks) ticks = (uint32_t)elapsed;
+
+	//restart the periodic tick:
+	tick.it_interval.tv_usec = OS_TICK_PERIOD_US;
+	tick.it_value = tick.it_interval;
+	setitimer(ITIMER_REAL, &tick, NULL);
+
+	return(ticks);
+}
+#endif
+
+#if OS_CYCLE_COUNTER_EN > 0
+/*
+ *  uLipePortCycleCount()
+ */
+uint32_t uLipePortCycleCount(void)
+{
+	struct timespec now;
+	uint64_t cycles;
+
+	//no cycle counter visible to the process, the monotonic clock is
+	//scaled to OS_CPU_RATE so the kernel sees the usual time base:
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	cycles = (uint64_t)now.tv_sec * OS_CPU_RATE;
+	cycles += ((uint64_t)now.tv_nsec * OS_CPU_RATE) / OS_PORT_NSEC_PER_SEC;
+
+	return((uint32_t)cycles);
+}
+#endif
+
+/*
+ *  uLipePortChange()
+ */
+void uLipePortChange(void)
+{
+	uint32_t sReg;
+
+	//request the switch, it is taken at the end of the outermost
+	//critical section or signal handler:
+	OS_CRITICAL_IN();
+	switchPending[OS_CORE_ID()] = TRUE;
+	OS_CRITICAL_OUT();
+}
+
+#if OS_ARCH_MULTICORE > 0
+/*
+ *  uLipePortSpinLock()
+ */
+void uLipePortSpinLock(void)
+{
+	//the holder may be preempted by the host, so give it the cpu
+	//instead of spinning the whole host time slice:
+	while(__atomic_test_and_set(&spinLock, __ATOMIC_ACQUIRE))
+	{
+		sched_yield();
+	}
+}
+
+/*
+ *  uLipePortSpinUnlock()
+ */
+void uLipePortSpinUnlock(void)
+{
+	__atomic_clear(&spinLock, __ATOMIC_RELEASE);
+}
+
+/*
+ *  uLipePortCoreSignal()
+ */
+void uLipePortCoreSignal(uint16_t core)
+{
+	pthread_kill(coreThread[core], OS_PORT_CORE_SIGNAL);
+}
+#endif
+
+/*
+ *  uLipePortBitLSScan()
+ */
+uint32_t uLipePortBitLSScan(uint32_t arg)
+{
+	if(arg == 0) return(32);
+	return(31 - (uint32_t)__builtin_ctz(arg));
+}
+
+/*
+ *  uLipePortBitFSScan()
+ */
+uint32_t uLipePortBitFSScan(uint32_t arg)
+{
+	if(arg == 0) return(32);
+	return((uint32_t)__builtin_clz(arg));
+}
+
+#endif
@@ -0,0 +1,575 @@
+/*!
+ *
+ * 							ULIPE RTOS VERSION 4
+ *
+ *
+ *  \file uLipeBench.c
+ *
+ *  \brief this file contains the kernel benchmark suite
+ *
+ *	In this file the user will find the benchmark cases, each one runs
+ *	OS_BENCH_ITERATIONS times and the cost of every operation is measured
+ *	with the port cycle counter, then a table with average, best and
+ *	worst case is printed.
+ *
+ *	The suite is a library, no target is provided to build it alone:
+ *	add this file to the user project, which supplies the startup code,
+ *	linker script and the printf used by OS_BENCH_PRINTF, then build it
+ *	with OS_CYCLE_COUNTER_EN set and call from main():
+ *
+ *		uLipeRtosInit();
+ *		uLipeBenchStart();
+ *		uLipeRtosStart();
+ *
+ *	When that project runs on qemu (e.g. with semihosting), note that
+ *	qemu does not model the cpu timing, with -icount the systick (used
+ *	as cycle counter, as the dwt is not emulated) advances with the
+ *	instructions executed, so the numbers are deterministic and good to
+ *	catch regressions between releases, absolute figures must be taken
+ *	on real hardware.
+ *
+ *  Author: FSN
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "uLipeBench.h"
+
+/*
+ * Module variables:
+ */
+OsBenchResult_t uLipeBenchResults[kBenchCases];	//results of last run
+
+static uint64_t benchTotal[kBenchCases];		//sum of samples of each case
+static uint32_t benchOverhead;					//cost of a cycle counter read
+static volatile uint32_t benchStamp;			//taken by the helper tasks
+
+static OsHandler_t benchSem[2];
+static OsHandler_t benchQueue;
+static OsHandler_t benchCopyQueue;
+static OsHandler_t benchMutex;
+static OsHandler_t benchFlags;
+
+static const char * const benchNames[kBenchCases] =
+{
+	"sem ping-pong round trip",
+	"queue insert to consumer",
+	"queue send 16 bytes copy",
+	"queue insert batch of 8",
+	"mutex handoff",
+	"flags broadcast",
+	"flags post, others waited",
+	"task delay 1 tick period",
+	"mem alloc",
+	"mem free",
+};
+
+/*
+ * Module implementation:
+ */
+
+/*
+ * BenchSample()
+ * Internal, accounts one measured operation
+ */
+static void BenchSample(OsBenchCase_t c, uint32_t cycles)
+{
+	OsBenchResultPtr_t r = &uLipeBenchResults[c];
+
+	//remove the cost of reading the counter itself:
+	cycles = (cycles > benchOverhead) ? (cycles - benchOverhead) : 0;
+
+	if((r->ops == 0) || (cycles < r->minCycles)) r->minCycles = cycles;
+	if(cycles > r->maxCycles) r->maxCycles = cycles;
+
+	benchTotal[c] += cycles;
+	r->ops++;
+	r->avgCycles = (uint32_t)(benchTotal[c] / r->ops);
+}
+
+/*
+ * BenchHelperCreate()
+ * Internal, creates a helper task on a prio above the bench task
+ */
+static void BenchHelperCreate(void (*task)(void *args), uint16_t prio)
+{
+	OsStatus_t err;
+
+	err = uLipeTaskCreate(task, OS_BENCH_HELPER_STACK_SIZE, prio,
+						  (void *)(uintptr_t)prio);
+	if(err != kStatusOk)
+	{
+		OS_BENCH_PRINTF("uLipeBench: cannot create helper task, error %d\n", (int)err);
+		OS_BENCH_EXIT();
+		for(;;);
+	}
+}
+
+/*
+ * BenchHelperDone()
+ * Internal, parks a helper task, so the bench task can delete it
+ */
+static void BenchHelperDone(void *args)
+{
+	uLipeTaskSuspend(OS_TASK_ID((uint16_t)(uintptr_t)args, 0));
+}
+
+/*
+ * BenchCalibrate()
+ * Internal, measures the cost of the cycle counter read
+ */
+static void BenchCalibrate(void)
+{
+	uint32_t start;
+	uint32_t i;
+
+	start = uLipePortCycleCount();
+	uLipeTaskDelay(2);
+	if(uLipePortCycleCount() == start)
+	{
+		OS_BENCH_PRINTF("uLipeBench: cycle counter is not running, "
+						"results are not valid\n");
+	}
+
+	benchOverhead = 0xFFFFFFFF;
+	for(i = 0; i < 16; i++)
+	{
+		start = uLipePortCycleCount();
+		start = uLipePortCycleCount() - start;
+		if(start < benchOverhead) benchOverhead = start;
+	}
+}
+
+/*
+ * BenchSemPongTask()
+ * Internal, answers each give of bench task
+ */
+static void BenchSemPongTask(void *args)
+{
+	uint32_t i;
+
+	for(i = 0; i < OS_BENCH_ITERATIONS; i++)
+	{
+		uLipeSemTake(benchSem[0], 0);
+		uLipeSemGive(benchSem[1], 1);
+	}
+
+	BenchHelperDone(args);
+}
+
+/*
+ * BenchSemPingPong()
+ * Internal, two tasks synchronized by a pair of semaphores, each round
+ * trip has two context switches
+ */
+static void BenchSemPingPong(void)
+{
+	uint32_t start;
+	uint32_t i;
+
+	BenchHelperCreate(&BenchSemPongTask, OS_BENCH_PRIO + 1);
+
+	for(i = 0; i < OS_BENCH_ITERATIONS; i++)
+	{
+		start = uLipePortCycleCount();
+		uLipeSemGive(benchSem[0], 1);
+		uLipeSemTake(benchSem[1], 0);
+		BenchSample(kBenchSemPingPong, uLipePortCycleCount() - start);
+	}
+
+	uLipeTaskDelete(OS_TASK_ID(OS_BENCH_PRIO + 1, 0));
+}
+
+/*
+ * BenchQueueConsumerTask()
+ * Internal, drains the queue filled by bench task
+ */
+static void BenchQueueConsumerTask(void *args)
+{
+	OsStatus_t err;
+	uint32_t i;
+
+	for(i = 0; i < OS_BENCH_ITERATIONS; i++)
+	{
+		//a blocking remove returns empty handed when woken, try again:
+		while(uLipeQueueRemove(benchQueue, OS_Q_BLOCK_EMPTY, 0, &err) == NULL);
+	}
+
+	BenchHelperDone(args);
+}
+
+/*
+ * BenchQueueThroughput()
+ * Internal, each insert wakes the consumer which takes the message
+ */
+static void BenchQueueThroughput(void)
+{
+	uint32_t start;
+	uint32_t i;
+
+	BenchHelperCreate(&BenchQueueConsumerTask, OS_BENCH_PRIO + 1);
+
+	for(i = 0; i < OS_BENCH_ITERATIONS; i++)
+	{
+		start = uLipePortCycleCount();
+		uLipeQueueInsert(benchQueue, (void *)(uintptr_t)(i + 1), OS_Q_BLOCK_FULL, 0);
+		BenchSample(kBenchQueueThroughput, uLipePortCycleCount() - start);
+	}
+
+	uLipeTaskDelete(OS_TASK_ID(OS_BENCH_PRIO + 1, 0));
+}
+
+/*
+ * BenchQueueCopyConsumerTask()
+ * Internal, drains the copy queue filled by bench task
+ */
+static void BenchQueueCopyConsumerTask(void *args)
+{
+	uint32_t item[4];
+	uint32_t i;
+
+	for(i = 0; i < OS_BENCH_ITERATIONS; i++)
+	{
+		uLipeQueueReceive(benchCopyQueue, item, OS_Q_BLOCK_EMPTY, 0);
+	}
+
+	BenchHelperDone(args);
+}
+
+/*
+ * BenchQueueCopy()
+ * Internal, like the queue throughput but the sample is copied in and out
+ */
+static void BenchQueueCopy(void)
+{
+	uint32_t item[4];
+	uint32_t start;
+	uint32_t i;
+
+	BenchHelperCreate(&BenchQueueCopyConsumerTask, OS_BENCH_PRIO + 1);
+
+	for(i = 0; i < OS_BENCH_ITERATIONS; i++)
+	{
+		item[0] = i;
+		start = uLipePortCycleCount();
+		uLipeQueueSend(benchCopyQueue, item, OS_Q_BLOCK_FULL, 0);
+		BenchSample(kBenchQueueCopy, uLipePortCycleCount() - start);
+	}
+
+	uLipeTaskDelete(OS_TASK_ID(OS_BENCH_PRIO + 1, 0));
+}
+
+/*
+ * BenchQueueBatchConsumerTask()
+ * Internal, drains each batch inserted by bench task at once
+ */
+static void BenchQueueBatchConsumerTask(void *args)
+{
+	void *items[OS_BENCH_BATCH];
+	uint32_t i;
+
+	for(i = 0; i < OS_BENCH_ITERATIONS; i++)
+	{
+		uLipeQueueRemoveN(benchQueue, items, OS_BENCH_BATCH, OS_Q_BLOCK_EMPTY, 0, NULL);
+	}
+
+	BenchHelperDone(args);
+}
+
+/*
+ * BenchQueueBatch()
+ * Internal, a whole batch is inserted with a single wake up of the consumer
+ */
+static void BenchQueueBatch(void)
+{
+	void *items[OS_BENCH_BATCH];
+	uint32_t start;
+	uint32_t i;
+
+	for(i = 0; i < OS_BENCH_BATCH; i++)
+	{
+		items[i] = (void *)(uintptr_t)(i + 1);
+	}
+
+	BenchHelperCreate(&BenchQueueBatchConsumerTask, OS_BENCH_PRIO + 1);
+
+	for(i = 0; i < OS_BENCH_ITERATIONS; i++)
+	{
+		start = uLipePortCycleCount();
+		uLipeQueueInsertN(benchQueue, items, OS_BENCH_BATCH, OS_Q_BLOCK_FULL, 0, NULL);
+		BenchSample(kBenchQueueBatch, uLipePortCycleCount() - start);
+	}
+
+	uLipeTaskDelete(OS_TASK_ID(OS_BENCH_PRIO + 1, 0));
+}
+
+/*
+ * BenchMutexWaiterTask()
+ * Internal, measures from the give of bench task until it owns the mutex
+ */
+static void BenchMutexWaiterTask(void *args)
+{
+	uint32_t i;
+
+	for(i = 0; i < OS_BENCH_ITERATIONS; i++)
+	{
+		uLipeSemTake(benchSem[0], 0);
+		uLipeMutexTake(benchMutex);
+		BenchSample(kBenchMutexHandoff, uLipePortCycleCount() - benchStamp);
+		uLipeMutexGive(benchMutex);
+	}
+
+	BenchHelperDone(args);
+}
+
+/*
+ * BenchMutexHandoff()
+ * Internal, the waiter is released while bench task holds the mutex
+ */
+static void BenchMutexHandoff(void)
+{
+	uint32_t i;
+
+	BenchHelperCreate(&BenchMutexWaiterTask, OS_BENCH_PRIO + 1);
+
+	for(i = 0; i < OS_BENCH_ITERATIONS; i++)
+	{
+		uLipeMutexTake(benchMutex);
+		uLipeSemGive(benchSem[0], 1);
+		benchStamp = uLipePortCycleCount();
+		uLipeMutexGive(benchMutex);
+	}
+
+	uLipeTaskDelete(OS_TASK_ID(OS_BENCH_PRIO + 1, 0));
+}
+
+/*
+ * BenchFlagsWaiterTask()
+ * Internal, the lowest prio waiter is the last to stamp
+ */
+static void BenchFlagsWaiterTask(void *args)
+{
+	for(;;)
+	{
+		uLipeFlagsPend(benchFlags, 0x01, OS_FLAGS_PEND_ANY, 0);
+		benchStamp = uLipePortCycleCount();
+		BenchHelperDone(args);
+	}
+}
+
+/*
+ * BenchFlagsBroadcast()
+ * Internal, a single post wakes all the waiters
+ */
+static void BenchFlagsBroadcast(void)
+{
+	uint32_t start;
+	uint32_t i;
+	uint16_t w;
+
+	for(w = 1; w <= OS_BENCH_FLAGS_WAITERS; w++)
+	{
+		BenchHelperCreate(&BenchFlagsWaiterTask, OS_BENCH_PRIO + w);
+	}
+
+	for(i = 0; i < OS_BENCH_ITERATIONS; i++)
+	{
+		start = uLipePortCycleCount();
+		uLipeFlagsPost(benchFlags, 0x01);
+		BenchSample(kBenchFlagsBroadcast, benchStamp - start);
+
+		//consume the flags, then waiters pend on them again:
+		uLipeFlagsPend(benchFlags, 0x01, OS_FLAGS_PEND_ANY | OS_FLAGS_CONSUME, 0);
+		if(i == (OS_BENCH_ITERATIONS - 1)) break;
+
+		for(w = 1; w <= OS_BENCH_FLAGS_WAITERS; w++)
+		{
+			uLipeTaskResume(OS_TASK_ID(OS_BENCH_PRIO + w, 0));
+		}
+	}
+
+	for(w = 1; w <= OS_BENCH_FLAGS_WAITERS; w++)
+	{
+		uLipeTaskDelete(OS_TASK_ID(OS_BENCH_PRIO + w, 0));
+	}
+}
+
+/*
+ * BenchFlagsOtherWaiterTask()
+ * Internal, pends its own flag, never posted by the measured case
+ */
+static void BenchFlagsOtherWaiterTask(void *args)
+{
+	uint16_t bit = (uint16_t)(uintptr_t)args - OS_BENCH_PRIO;
+
+	uLipeFlagsPend(benchFlags, (uint32_t)1 << bit, OS_FLAGS_PEND_ANY | OS_FLAGS_CONSUME, 0);
+	BenchHelperDone(args);
+}
+
+/*
+ * BenchFlagsFiltered()
+ * Internal, a post which wakes nobody, only the waiters of the posted
+ * flag are checked
+ */
+static void BenchFlagsFiltered(void)
+{
+	uint32_t start;
+	uint32_t i;
+	uint16_t w;
+
+	for(w = 1; w <= OS_BENCH_FLAGS_WAITERS; w++)
+	{
+		BenchHelperCreate(&BenchFlagsOtherWaiterTask, OS_BENCH_PRIO + w);
+	}
+
+	for(i = 0; i < OS_BENCH_ITERATIONS; i++)
+	{
+		start = uLipePortCycleCount();
+		uLipeFlagsPost(benchFlags, 0x01);
+		BenchSample(kBenchFlagsFiltered, uLipePortCycleCount() - start);
+
+		uLipeFlagsPend(benchFlags, 0x01, OS_FLAGS_PEND_ANY | OS_FLAGS_CONSUME, 0);
+	}
+
+	//release the waiters, each one consumes its own flag:
+	uLipeFlagsPost(benchFlags, (0xFFFFFFFF >> (31 - OS_BENCH_FLAGS_WAITERS)) & ~0x01);
+
+	for(w = 1; w <= OS_BENCH_FLAGS_WAITERS; w++)
+	{
+		uLipeTaskDelete(OS_TASK_ID(OS_BENCH_PRIO + w, 0));
+	}
+}
+
+/*
+ * BenchDelayPeriod()
+ * Internal, the period spread is the wake up jitter
+ */
+static void BenchDelayPeriod(void)
+{
+	uint32_t start;
+	uint32_t now;
+	uint32_t i;
+
+	//align with the tick first:
+	uLipeTaskDelay(1);
+	start = uLipePortCycleCount();
+
+	for(i = 0; i < OS_BENCH_DELAY_SAMPLES; i++)
+	{
+		uLipeTaskDelay(1);
+		now = uLipePortCycleCount();
+		BenchSample(kBenchDelayPeriod, now - start);
+		start = now;
+	}
+}
+
+/*
+ * BenchMem()
+ * Internal, allocation and release of the same block
+ */
+static void BenchMem(void)
+{
+	uint32_t start;
+	uint32_t i;
+	void *mem;
+
+	for(i = 0; i < OS_BENCH_ITERATIONS; i++)
+	{
+		start = uLipePortCycleCount();
+		mem = uLipeMemAlloc(OS_BENCH_MEM_BLOCK_SIZE);
+		BenchSample(kBenchMemAlloc, uLipePortCycleCount() - start);
+		if(mem == NULL) break;
+
+		start = uLipePortCycleCount();
+		uLipeMemFree(mem);
+		BenchSample(kBenchMemFree, uLipePortCycleCount() - start);
+	}
+}
+
+/*
+ * BenchReport()
+ * Internal, prints the results table
+ */
+static void BenchReport(void)
+{
+	OsBenchResultPtr_t r;
+	uint32_t i;
+
+	OS_BENCH_PRINTF("\nuLipeRTOS benchmark, cycles at %lu Hz, counter read %lu cycles\n",
+					(unsigned long)OS_CPU_RATE, (unsigned long)benchOverhead);
+	OS_BENCH_PRINTF("%-28s %8s %8s %8s %8s\n", "case", "ops", "avg", "min", "max");
+
+	for(i = 0; i < kBenchCases; i++)
+	{
+		r = &uLipeBenchResults[i];
+		OS_BENCH_PRINTF("%-28s %8lu %8lu %8lu %8lu\n", r->name,
+						(unsigned long)r->ops, (unsigned long)r->avgCycles,
+						(unsigned long)r->minCycles, (unsigned long)r->maxCycles);
+	}
+
+	r = &uLipeBenchResults[kBenchDelayPeriod];
+	OS_BENCH_PRINTF("flags broadcast wakes %d tasks, delay period expected %lu, jitter %lu\n",
+					OS_BENCH_FLAGS_WAITERS, (unsigned long)(OS_CPU_RATE / OS_TICK_RATE),
+					(unsigned long)(r->maxCycles - r->minCycles));
+}
+
+/*
+ * BenchTask()
+ * Internal, runs all the cases in sequence
+ */
+static void BenchTask(void *args)
+{
+	(void)args;
+
+	BenchCalibrate();
+
+	BenchSemPingPong();
+	BenchQueueThroughput();
+	BenchQueueCopy();
+	BenchQueueBatch();
+	BenchMutexHandoff();
+	BenchFlagsBroadcast();
+	BenchFlagsFiltered();
+	BenchDelayPeriod();
+	BenchMem();
+
+	BenchReport();
+	OS_BENCH_EXIT();
+
+	for(;;)
+	{
+		uLipeTaskSuspend(OS_TASK_ID(OS_BENCH_PRIO, 0));
+	}
+}
+
+/*
+ * uLipeBenchStart()
+ */
+OsStatus_t uLipeBenchStart(void)
+{
+	OsStatus_t err;
+	uint32_t i;
+
+	memset(benchTotal, 0, sizeof(benchTotal));
+	for(i = 0; i < kBenchCases; i++)
+	{
+		memset(&uLipeBenchResults[i], 0, sizeof(OsBenchResult_t));
+		uLipeBenchResults[i].name = benchNames[i];
+	}
+
+	//kernel objects used by the cases:
+	benchSem[0] = uLipeSemCreate(0, 1, &err);
+	if(err != kStatusOk) return(err);
+	benchSem[1] = uLipeSemCreate(0, 1, &err);
+	if(err != kStatusOk) return(err);
+	benchQueue = uLipeQueueCreate(8, &err);
+	if(err != kStatusOk) return(err);
+	benchCopyQueue = uLipeQueueCreateCopy(4 * sizeof(uint32_t), 8, &err);
+	if(err != kStatusOk) return(err);
+	benchMutex = uLipeMutexCreate(&err);
+	if(err != kStatusOk) return(err);
+	benchFlags = uLipeFlagsCreate(&err);
+	if(err != kStatusOk) return(err);
+
+	return(uLipeTaskCreate(&BenchTask, OS_BENCH_STACK_SIZE, OS_BENCH_PRIO, NULL));
+}
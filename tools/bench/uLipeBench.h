@@ -0,0 +1,126 @@
+/*!
+ *
+ * 							ULIPE RTOS VERSION 4
+ *
+ *
+ *  \file uLipeBench.h
+ *
+ *  \brief this file contains the interface of the kernel benchmark suite
+ *
+ *	In this file the user will find the benchmark cases and its results,
+ *	the suite measures the kernel primitives in cpu cycles using the
+ *	port cycle counter, it is linked into a user project, see uLipeBench.c
+ *	for how to call it.
+ *
+ *  Author: FSN
+ *
+ */
+
+#ifndef __ULIPE_BENCH_H
+#define __ULIPE_BENCH_H
+
+#include "uLipeRtos4.h"
+
+/*
+ * Benchmark configuration, can be overridden on compiler command line:
+ */
+#ifndef OS_BENCH_ITERATIONS
+#define OS_BENCH_ITERATIONS			1000	//operations measured per case
+#endif
+
+#ifndef OS_BENCH_DELAY_SAMPLES
+#define OS_BENCH_DELAY_SAMPLES		100		//task delay periods measured
+#endif
+
+#ifndef OS_BENCH_PRIO
+#define OS_BENCH_PRIO				1		//bench task, helpers use prios above it
+#endif
+
+#ifndef OS_BENCH_FLAGS_WAITERS
+#define OS_BENCH_FLAGS_WAITERS		4		//tasks woken by each flags post
+#endif
+
+#ifndef OS_BENCH_BATCH
+#define OS_BENCH_BATCH				8		//items moved by each batch, up to the queue size
+#endif
+
+#ifndef OS_BENCH_STACK_SIZE
+#define OS_BENCH_STACK_SIZE			256		//bench task stack, it calls printf
+#endif
+
+#ifndef OS_BENCH_HELPER_STACK_SIZE
+#define OS_BENCH_HELPER_STACK_SIZE	64
+#endif
+
+#ifndef OS_BENCH_MEM_BLOCK_SIZE
+#define OS_BENCH_MEM_BLOCK_SIZE		32		//bytes requested on alloc case
+#endif
+
+#ifndef OS_BENCH_PRINTF
+#define OS_BENCH_PRINTF				printf
+#endif
+
+#ifndef OS_BENCH_EXIT
+#define OS_BENCH_EXIT()				exit(0)	//ends the run, e.g. semihosting exit
+#endif
+
+#if OS_CYCLE_COUNTER_EN == 0
+  #error "uLipeBench: the benchmark needs the cycle counter, set OS_CYCLE_COUNTER_EN"
+#endif
+
+#if (OS_BENCH_PRIO == 0) || ((OS_BENCH_PRIO + OS_BENCH_FLAGS_WAITERS) > (OS_NUMBER_OF_TASKS - 1))
+  #error "uLipeBench: not enough priorities above idle for the bench tasks"
+#endif
+
+#if OS_BENCH_FLAGS_WAITERS > 31
+  #error "uLipeBench: each flags waiter needs its own flag"
+#endif
+
+/*
+ *  benchmark cases:
+ */
+typedef enum
+{
+	kBenchSemPingPong = 0,		//give / take round trip between two tasks
+	kBenchQueueThroughput,		//insert on queue waking the consumer task
+	kBenchQueueCopy,			//same with a 16 bytes item copied by value
+	kBenchQueueBatch,			//batch of 8 inserts taken by a single remove
+	kBenchMutexHandoff,			//from give until the waiting task owns it
+	kBenchFlagsBroadcast,		//post until the last of the waiters runs
+	kBenchFlagsFiltered,		//post of a flag with waiters only on other flags
+	kBenchDelayPeriod,			//period of a task looping on 1 tick delay
+	kBenchMemAlloc,				//allocation of a memory block
+	kBenchMemFree,				//release of a memory block
+	kBenchCases,
+}OsBenchCase_t;
+
+/*
+ * Result of a benchmark case, all in cpu cycles:
+ */
+struct benchResult_
+{
+	const char *name;			//case description
+	uint32_t ops;				//operations measured
+	uint32_t avgCycles;			//average per operation
+	uint32_t minCycles;			//best operation
+	uint32_t maxCycles;			//worst operation
+};
+
+typedef struct benchResult_  OsBenchResult_t;
+typedef struct benchResult_* OsBenchResultPtr_t;
+
+/*
+ * results of last run, can also be inspected by the debugger:
+ */
+extern OsBenchResult_t uLipeBenchResults[kBenchCases];
+
+/*!
+ * uLipeBenchStart()
+ * \brief Creates the benchmark task, call it between uLipeRtosInit() and
+ * uLipeRtosStart(), the results are printed when all cases are done
+ * \param
+ * \return kStatusOk if the bench task was created
+ */
+OsStatus_t uLipeBenchStart(void);
+
+#endif
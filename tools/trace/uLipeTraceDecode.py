@@ -0,0 +1,265 @@
+#!/usr/bin/env python3
+#
+#                           ULIPE RTOS VERSION 4
+#
+#
+#  \file uLipeTraceDecode.py
+#
+#  \brief converts a raw dump of the kernel trace buffer into a Chrome
+#  trace / Perfetto JSON file
+#
+#  Dump the osTraceBuffer symbol from target ram, for example on gdb:
+#
+#      dump binary value trace.bin osTraceBuffer
+#
+#  then convert it and open the result on chrome://tracing or
+#  ui.perfetto.dev:
+#
+#      uLipeTraceDecode.py trace.bin -o trace.json --name 3=uart_rx
+#
+#  Author: FSN
+#
+
+import argparse
+import json
+import struct
+import sys
+
+#
+# must match the definitions on include/microkernel/OsTrace.h
+#
+TRACE_MAGIC = 0x52544C75
+TRACE_VERSION = 1
+TRACE_NO_TASK = 0xFFFF
+HEADER_FORMAT = "<IHHIII"
+RECORD_FORMAT = "<IHBBI"
+
+EVENTS = {
+    1: "switch",
+    2: "ready",
+    3: "block",
+    4: "isr enter",
+    5: "isr exit",
+    6: "sem take",
+    7: "sem give",
+    8: "queue insert",
+    9: "queue remove",
+    10: "flags pend",
+    11: "flags post",
+    12: "mutex take",
+    13: "mutex give",
+    14: "mem alloc",
+    15: "mem free",
+}
+
+# events which may make other tasks ready, linked to them with flow arrows:
+POST_EVENTS = (7, 8, 9, 11, 13)
+
+PID = 1
+ISR_TID = 0x10000
+BOOT_TID = 0x10001
+
+
+def parse_dump(data):
+    hdr_size = struct.calcsize(HEADER_FORMAT)
+    if len(data) < hdr_size:
+        raise ValueError("dump too short")
+
+    magic, version, rec_size, size, head, cpu_rate = struct.unpack_from(
+        HEADER_FORMAT, data, 0)
+
+    if magic != TRACE_MAGIC:
+        raise ValueError("bad magic 0x%08x, not a uLipe trace dump" % magic)
+    if version != TRACE_VERSION:
+        raise ValueError("unsupported trace version %d" % version)
+    if rec_size < struct.calcsize(RECORD_FORMAT):
+        raise ValueError("bad record size %d" % rec_size)
+    if len(data) < hdr_size + size * rec_size:
+        raise ValueError("dump truncated, expected %d records" % size)
+
+    # oldest record first, the ring is full once head passes its size:
+    if head <= size:
+        order = range(head)
+    else:
+        order = [(head + i) % size for i in range(size)]
+
+    records = []
+    for i in order:
+        ts, task, event, _, arg = struct.unpack_from(
+            RECORD_FORMAT, data, hdr_size + i * rec_size)
+        records.append((ts, task, event, arg))
+
+    return records, cpu_rate, max(head - size, 0)
+
+
+def unwrap(records):
+    # timestamps are 32bit cycle counts, make them monotonic:
+    base = 0
+    prev = None
+    out = []
+    for ts, task, event, arg in records:
+        if prev is not None and ts < prev:
+            base += 1 << 32
+        prev = ts
+        out.append((base + ts, task, event, arg))
+    return out
+
+
+def task_tid(task):
+    return BOOT_TID if task == TRACE_NO_TASK else task
+
+
+def convert(records, cpu_rate, names):
+    events = []
+    tasks = set()
+    running = None
+    isr_depth = 0
+    last_post = None
+    pending_ready = {}
+    flow_id = 0
+
+    if not records:
+        return events
+
+    t0 = records[0][0]
+
+    def usec(ts):
+        return (ts - t0) * 1000000.0 / cpu_rate
+
+    def slice_begin(tid, ts):
+        events.append({"ph": "B", "pid": PID, "tid": tid, "ts": usec(ts),
+                       "name": names.get(tid, "task %d" % tid), "cat": "sched"})
+
+    def slice_end(tid, ts):
+        events.append({"ph": "E", "pid": PID, "tid": tid, "ts": usec(ts)})
+
+    def instant(tid, ts, name, args):
+        events.append({"ph": "i", "s": "t", "pid": PID, "tid": tid,
+                       "ts": usec(ts), "name": name, "cat": "kernel",
+                       "args": args})
+
+    def flow(ph, tid, ts, ident):
+        ev = {"ph": ph, "pid": PID, "tid": tid, "ts": usec(ts),
+              "name": "wakeup", "cat": "flow", "id": ident}
+        if ph == "f":
+            ev["bp"] = "e"
+        events.append(ev)
+
+    for ts, task, event, arg in records:
+        name = EVENTS.get(event, "event %d" % event)
+        ctx = ISR_TID if isr_depth > 0 else task_tid(task)
+        tasks.add(task_tid(task))
+
+        if running is None and task != TRACE_NO_TASK:
+            running = task
+            slice_begin(running, ts)
+
+        if event == 1:
+            if running is not None:
+                slice_end(running, ts)
+            running = arg
+            tasks.add(arg)
+            slice_begin(running, ts)
+            if arg in pending_ready:
+                flow("f", arg, ts, pending_ready.pop(arg))
+            last_post = None
+
+        elif event in (2, 3):
+            tasks.add(arg)
+            instant(arg, ts, name, {"by": ctx})
+            if event == 2 and last_post is not None and last_post[0] == ctx:
+                flow_id += 1
+                flow("s", ctx, last_post[1], flow_id)
+                flow("t", arg, ts, flow_id)
+                pending_ready[arg] = flow_id
+
+        elif event == 4:
+            isr_depth = arg
+            events.append({"ph": "B", "pid": PID, "tid": ISR_TID,
+                           "ts": usec(ts), "name": "isr", "cat": "isr",
+                           "args": {"nesting": arg}})
+
+        elif event == 5:
+            isr_depth = max(arg - 1, 0)
+            events.append({"ph": "E", "pid": PID, "tid": ISR_TID,
+                           "ts": usec(ts)})
+
+        elif event == 14:
+            instant(ctx, ts, name, {"size": arg})
+
+        elif event == 15:
+            instant(ctx, ts, name, {"block": "0x%08x" % arg})
+
+        else:
+            instant(ctx, ts, name, {"object": "0x%08x" % arg})
+            if event in POST_EVENTS:
+                last_post = (ctx, ts)
+
+    if running is not None:
+        slice_end(running, records[-1][0])
+
+    # thread names, idle task always takes the first id:
+    meta = [{"ph": "M", "pid": PID, "name": "process_name",
+             "args": {"name": "uLipeRTOS"}},
+            {"ph": "M", "pid": PID, "tid": ISR_TID, "name": "thread_name",
+             "args": {"name": "interrupts"}}]
+    for tid in sorted(tasks):
+        if tid == BOOT_TID:
+            label = "boot"
+        elif tid in names:
+            label = names[tid]
+        elif tid == 0:
+            label = "idle"
+        else:
+            label = "task %d" % tid
+        meta.append({"ph": "M", "pid": PID, "tid": tid, "name": "thread_name",
+                     "args": {"name": label}})
+        meta.append({"ph": "M", "pid": PID, "tid": tid,
+                     "name": "thread_sort_index", "args": {"sort_index": -tid}})
+
+    return meta + events
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="convert a uLipeRTOS trace dump to Chrome/Perfetto JSON")
+    parser.add_argument("dump", help="raw dump of osTraceBuffer")
+    parser.add_argument("-o", "--output", help="output file, stdout if omitted")
+    parser.add_argument("--cpu-rate", type=int,
+                        help="override the timestamp frequency in Hz")
+    parser.add_argument("--name", action="append", default=[],
+                        metavar="ID=NAME", help="label a task id")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as f:
+        data = f.read()
+
+    try:
+        records, cpu_rate, lost = parse_dump(data)
+    except ValueError as e:
+        sys.stderr.write("%s: %s\n" % (args.dump, e))
+        return 1
+
+    if args.cpu_rate:
+        cpu_rate = args.cpu_rate
+
+    names = {}
+    for n in args.name:
+        ident, _, label = n.partition("=")
+        names[int(ident, 0)] = label
+
+    trace = {"traceEvents": convert(unwrap(records), cpu_rate, names),
+             "displayTimeUnit": "ns",
+             "otherData": {"records": len(records), "overwritten": lost,
+                           "cpuRate": cpu_rate}}
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    json.dump(trace, out, indent=1)
+    if args.output:
+        out.close()
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -23,12 +23,17 @@
 
 #include "include/microkernel/OsBase.h"
 #include "include/microkernel/OsPort.h"
+#include "include/microkernel/OsTrace.h"
 #include "include/microkernel/OsKernel.h"
 #include "include/microkernel/OsTask.h"
 #include "include/microkernel/OsFlags.h"
 #include "include/microkernel/OsQueue.h"
+#include "include/microkernel/OsRing.h"
+#include "include/microkernel/OsStream.h"
 #include "include/microkernel/OsMutex.h"
 #include "include/microkernel/OsSem.h"
+#include "include/microkernel/OsSet.h"
+#include "include/microkernel/OsTimer.h"
 #include "include/microkernel/OsMem.h"
 #include "include/microkernel/OsDeviceDriver.h"
 